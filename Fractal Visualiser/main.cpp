@@ -1,8 +1,246 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <core/Application.h>
+#include <core/Benchmark.h>
+#include <core/Microbenchmark.h>
+#include <core/PngWriter.h>
+#include <core/Regression.h>
+#include <core/SelfCheck.h>
+#include <core/Window.h>
+#include <cpu/MandelbulbRenderer.h>
+#include <cpu/Mesher.h>
+#include <renderer/GL43.h>
+
+// value following a --name flag, or nullptr when it was not given
+static const char* FindOption(int argc, char** argv, const char* name)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::strcmp(argv[i], name) == 0)
+			return argv[i + 1];
+	}
+	return nullptr;
+}
+
+// --export-mesh out.ply|out.stl [--power 8] [--iterations 20] [--resolution 2048] [--threads 0]
+static int ExportMesh(int argc, char** argv, const std::string& path)
+{
+	MeshWriter::Format format;
+	if (!MeshWriter::FormatFromPath(path, format)) {
+		std::cout << "Mesh export: " << path << " is not a .ply or .stl file" << std::endl;
+		return 1;
+	}
+
+	Mesher::Settings settings;
+	if (const char* value = FindOption(argc, argv, "--power"))
+		settings.power = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--iterations"))
+		settings.iterations = std::atoi(value);
+	if (const char* value = FindOption(argc, argv, "--resolution"))
+		settings.resolution = std::atoi(value);
+	if (const char* value = FindOption(argc, argv, "--threads"))
+		settings.threads = static_cast<unsigned int>(std::atoi(value));
+
+	if (settings.resolution < 1 || settings.resolution > Mesher::c_MaxResolution) {
+		std::cout << "Mesh export: --resolution must be between 1 and " << Mesher::c_MaxResolution << std::endl;
+		return 1;
+	}
+
+	MeshWriter writer(path, format);
+	if (!writer.IsOpen()) {
+		std::cout << "Mesh export: could not open " << path << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	size_t triangles = Mesher(settings).Run(writer);
+	writer.Close();
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Wrote " << triangles << " triangles to " << path << " in " << seconds << "s" << std::endl;
+	return 0;
+}
+
+// --render-bulb out.png [--width 1280] [--height 720] [--angle 0] [--power 8] [--iterations 20] [--threads 0]
+static int RenderBulb(int argc, char** argv, const std::string& path)
+{
+	MandelbulbRenderer::Settings settings;
+	if (const char* value = FindOption(argc, argv, "--width"))
+		settings.width = std::atoi(value);
+	if (const char* value = FindOption(argc, argv, "--height"))
+		settings.height = std::atoi(value);
+	if (const char* value = FindOption(argc, argv, "--angle"))
+		settings.angle = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--power"))
+		settings.power = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--iterations"))
+		settings.iterations = std::atoi(value);
+	if (const char* value = FindOption(argc, argv, "--threads"))
+		settings.threads = static_cast<unsigned int>(std::atoi(value));
+
+	if (settings.width < 1 || settings.height < 1) {
+		std::cout << "Render: the image needs a width and height of at least 1" << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uint8_t> pixels = MandelbulbRenderer(settings).Render();
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!PngWriter::Save(path.c_str(), pixels.data(), settings.width, settings.height)) {
+		std::cout << "Render: could not write " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << "Rendered " << settings.width << "x" << settings.height << " to " << path << " in " << seconds << "s" << std::endl;
+	return 0;
+}
+
+// --microbench out.json [--points 4096] [--iterations 1000] [--threads 0]
+static int RunMicrobenchmark(int argc, char** argv, const std::string& path)
+{
+	Microbenchmark::Settings settings;
+	if (const char* value = FindOption(argc, argv, "--points"))
+		settings.points = std::max(1, std::atoi(value));
+	if (const char* value = FindOption(argc, argv, "--iterations"))
+		settings.iterations = std::max(1, std::atoi(value));
+	if (const char* value = FindOption(argc, argv, "--threads"))
+		settings.maxThreads = static_cast<unsigned int>(std::max(0, std::atoi(value)));
+
+	Microbenchmark microbenchmark(settings);
+	microbenchmark.Run();
+
+	if (!microbenchmark.WriteJSON(path)) {
+		std::cout << "Microbenchmark: could not write " << path << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << path << std::endl;
+	return 0;
+}
+
+// a hidden window for its GL context, for the tools that draw offscreen;
+// useCompute is cleared when GL 4.3 is not there
+static bool CreateHiddenContext(const char* tool, bool& useCompute)
+{
+	if (!glfwInit()) {
+		std::cout << tool << ": failed to initialise GLFW" << std::endl;
+		return false;
+	}
+
+	Window::Init("Fractal Visualiser", 64, 64, false);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		std::cout << tool << ": failed to initialise GLAD" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	if (useCompute && !GL43::Load((GLADloadproc)glfwGetProcAddress)) {
+		std::cout << tool << ": the compute backend needs OpenGL 4.3, using the fragment shaders" << std::endl;
+		useCompute = false;
+	}
+	return true;
+}
+
+// --benchmark scenes.txt [--output benchmark.json] [--frames 30] [--warmup 3] [--backend fragment|compute]
+static int RunBenchmark(int argc, char** argv, const std::string& path)
+{
+	std::vector<BenchmarkScene> scenes;
+	std::string error;
+	if (!Benchmark::LoadScenes(path, scenes, error)) {
+		std::cout << "Benchmark: " << error << std::endl;
+		return 1;
+	}
+
+	Benchmark::Settings settings;
+	if (const char* value = FindOption(argc, argv, "--frames"))
+		settings.frames = std::max(1, std::atoi(value));
+	if (const char* value = FindOption(argc, argv, "--warmup"))
+		settings.warmupFrames = std::max(0, std::atoi(value));
+	const char* backend = FindOption(argc, argv, "--backend");
+	settings.useCompute = backend && std::strcmp(backend, "compute") == 0;
+	const char* output = FindOption(argc, argv, "--output");
+
+	// the scenes draw offscreen at their own size
+	if (!CreateHiddenContext("Benchmark", settings.useCompute))
+		return 1;
+
+	int result = 0;
+	{
+		Benchmark benchmark(settings);
+		benchmark.Run(scenes);
+
+		std::string outputPath = output ? output : "benchmark.json";
+		if (benchmark.WriteJSON(outputPath)) {
+			std::cout << "Wrote " << outputPath << std::endl;
+		}
+		else {
+			std::cout << "Benchmark: could not write " << outputPath << std::endl;
+			result = 1;
+		}
+	}
+
+	glfwTerminate();
+	return result;
+}
+
+// --regression scenes.txt [--output dir] [--tolerance 0.05] [--max-mismatch 0.005] [--max-unstable 0.5] [--backend fragment|compute]
+// exits with 1 when any scene drifted from the CPU reference, or a CPU self check failed
+static int RunRegression(int argc, char** argv, const std::string& path)
+{
+	std::vector<BenchmarkScene> scenes;
+	std::string error;
+	if (!Benchmark::LoadScenes(path, scenes, error)) {
+		std::cout << "Regression: " << error << std::endl;
+		return 1;
+	}
+
+	Regression::Settings settings;
+	if (const char* value = FindOption(argc, argv, "--tolerance"))
+		settings.tolerance = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--max-mismatch"))
+		settings.maxMismatch = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--max-unstable"))
+		settings.maxUnstable = static_cast<float>(std::atof(value));
+	if (const char* value = FindOption(argc, argv, "--output"))
+		settings.outputDirectory = value;
+	const char* backend = FindOption(argc, argv, "--backend");
+	settings.useCompute = backend && std::strcmp(backend, "compute") == 0;
+
+	if (!SelfCheck::Run()) {
+		std::cout << "Regression: CPU self checks failed" << std::endl;
+		return 1;
+	}
+
+	if (!CreateHiddenContext("Regression", settings.useCompute))
+		return 1;
+
+	bool isPassed;
+	{
+		Regression regression(settings);
+		isPassed = regression.Run(scenes);
+	}
+	std::cout << (isPassed ? "All scenes match the CPU reference" : "Some scenes drifted from the CPU reference") << std::endl;
+
+	glfwTerminate();
+	return isPassed ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	if (const char* path = FindOption(argc, argv, "--export-mesh"))
+		return ExportMesh(argc, argv, path);
+	if (const char* path = FindOption(argc, argv, "--render-bulb"))
+		return RenderBulb(argc, argv, path);
+	if (const char* path = FindOption(argc, argv, "--benchmark"))
+		return RunBenchmark(argc, argv, path);
+	if (const char* path = FindOption(argc, argv, "--microbench"))
+		return RunMicrobenchmark(argc, argv, path);
+	if (const char* path = FindOption(argc, argv, "--regression"))
+		return RunRegression(argc, argv, path);
 
-int main() {
 	Application::GetInstance()->Run();
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,196 @@
+#shader compute
+
+#version 430
+
+// FRACTAL is injected by the application: 0 mandelbrot, 1 burning ship, 2 tricorn
+#ifndef FRACTAL
+#define FRACTAL 0
+#endif
+
+// HISTOGRAM_BINS is injected too, to match IterationHistogram
+#ifndef HISTOGRAM_BINS
+#define HISTOGRAM_BINS 64
+#endif
+
+// SEED_PASS builds the kernel that starts every pixel, otherwise the kernel
+// continues the pixels left in the input work list
+#define B 4.
+#define LOCAL_SIZE 256
+
+#ifdef SEED_PASS
+layout(local_size_x = 16, local_size_y = 16) in;
+#else
+layout(local_size_x = LOCAL_SIZE) in;
+#endif
+
+layout(r32f, binding = 0) uniform writeonly image2D iterationBuffer;
+
+// a pixel that has not escaped yet, with everything needed to carry on
+struct WorkItem {
+    uint pixel;
+    int iters;
+    vec2 z;
+};
+
+layout(std430, binding = 1) buffer WorkCounts {
+    uint listCount[2];
+};
+
+layout(std430, binding = 2) readonly buffer InputList {
+    WorkItem inputItems[];
+};
+
+layout(std430, binding = 3) writeonly buffer OutputList {
+    WorkItem outputItems[];
+};
+
+// escape counts of the pixels finished in this pass, binned as in escapetime_compute.shader
+layout(std430, binding = 4) buffer Histogram {
+    uint histogram[HISTOGRAM_BINS + 1];
+};
+
+uniform ivec2 resolution = ivec2(1280, 720);
+uniform vec2 location = vec2(0, 0);
+uniform vec2 mousePos = vec2(0, 0);
+uniform bool juliaMode = false;
+uniform float zoom = 2.0;
+uniform int iterations = 200;
+
+// iterations run per pass before a pixel is parked in the output list
+uniform int chunkSize = 64;
+// which of the two counts belongs to the input list, the other one is the output
+uniform int inputSlot = 0;
+
+shared uint s_Survivors;
+shared uint s_OutputBase;
+shared uint s_Histogram[HISTOGRAM_BINS + 1];
+
+vec2 iterate(vec2 z)
+{
+#if FRACTAL == 1
+    // burning ship
+    float temp = abs(z.x);
+    z.x = abs(z.x * z.x) - abs(z.y * z.y);
+    z.y = 2.0 * temp * abs(z.y);
+#elif FRACTAL == 2
+    // tricorn
+    z = vec2(z.x, -z.y);
+    float temp = z.x;
+    z.x = z.x * z.x - z.y * z.y;
+    z.y = 2.0 * temp * z.y;
+#else
+    // mandelbrot
+    float temp = z.x;
+    z.x = z.x * z.x - z.y * z.y;
+    z.y = 2.0 * temp * z.y;
+#endif
+    return z;
+}
+
+// same mapping as the fragment shaders, evaluated at the pixel centre
+vec2 pixelToPlane(ivec2 pixel)
+{
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(resolution);
+    float ratio = float(resolution.x) / resolution.y;
+    uv.x *= ratio;
+    uv -= vec2(ratio / 2, 0.5);
+
+    uv *= zoom;
+    uv += location;
+
+    uv.y *= -1;
+    return uv;
+}
+
+// runs up to one chunk of iterations, returns true when the pixel is finished
+bool advance(ivec2 pixel, inout int iters, inout vec2 z)
+{
+    vec2 point = juliaMode ? mousePos : pixelToPlane(pixel);
+
+    int stop = min(iters + chunkSize, iterations);
+    bool escaped = false;
+    for (; iters < stop; ++iters)
+    {
+        z = iterate(z) + point;
+        if (dot(z, z) > 4.0) {
+            escaped = true;
+            break;
+        }
+    }
+
+    if (escaped || iters >= iterations) {
+        uint bin = iters >= iterations ? uint(HISTOGRAM_BINS) : uint(iters * HISTOGRAM_BINS / iterations);
+        atomicAdd(s_Histogram[bin], 1u);
+        imageStore(iterationBuffer, pixel, vec4(iters - log(log(dot(z, z)) / log(B)) / log(2.)));
+        return true;
+    }
+    return false;
+}
+
+// appends the surviving items of this workgroup with a single global atomic
+void compact(bool alive, WorkItem item)
+{
+    if (gl_LocalInvocationIndex == 0u) {
+        s_Survivors = 0u;
+    }
+    barrier();
+
+    uint slot = 0u;
+    if (alive) {
+        slot = atomicAdd(s_Survivors, 1u);
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u) {
+        s_OutputBase = atomicAdd(listCount[1 - inputSlot], s_Survivors);
+    }
+    barrier();
+
+    if (alive) {
+        outputItems[s_OutputBase + slot] = item;
+    }
+    barrier();
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex <= uint(HISTOGRAM_BINS)) {
+        s_Histogram[gl_LocalInvocationIndex] = 0u;
+    }
+    barrier();
+
+#ifdef SEED_PASS
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    bool inside = all(lessThan(pixel, resolution));
+
+    WorkItem item;
+    item.pixel = uint(pixel.y * resolution.x + pixel.x);
+    item.iters = 0;
+    item.z = juliaMode ? pixelToPlane(pixel) : vec2(0.0);
+
+    bool alive = inside && !advance(pixel, item.iters, item.z);
+    compact(alive, item);
+#else
+    // persistent workgroups stride over the input list, the trip count is the
+    // same for every invocation of a group so the barriers in compact are safe
+    uint count = listCount[inputSlot];
+    uint stride = gl_NumWorkGroups.x * LOCAL_SIZE;
+    for (uint base = gl_WorkGroupID.x * LOCAL_SIZE; base < count; base += stride) {
+        uint index = base + gl_LocalInvocationIndex;
+
+        WorkItem item;
+        bool alive = false;
+        if (index < count) {
+            item = inputItems[index];
+            ivec2 pixel = ivec2(int(item.pixel) % resolution.x, int(item.pixel) / resolution.x);
+            alive = !advance(pixel, item.iters, item.z);
+        }
+        compact(alive, item);
+    }
+#endif
+
+    // compact ends on a barrier, so every pixel of the group has been binned
+    if (gl_LocalInvocationIndex <= uint(HISTOGRAM_BINS) && s_Histogram[gl_LocalInvocationIndex] != 0u) {
+        atomicAdd(histogram[gl_LocalInvocationIndex], s_Histogram[gl_LocalInvocationIndex]);
+    }
+}
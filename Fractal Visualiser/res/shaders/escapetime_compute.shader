@@ -0,0 +1,179 @@
+#shader compute
+
+#version 430
+
+// FRACTAL is injected by the application: 0 mandelbrot, 1 burning ship, 2 tricorn
+#ifndef FRACTAL
+#define FRACTAL 0
+#endif
+
+// HISTOGRAM_BINS is injected too, to match IterationHistogram
+#ifndef HISTOGRAM_BINS
+#define HISTOGRAM_BINS 64
+#endif
+
+#define B 4.
+#define TILE_SIZE 16
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+// smooth iteration count per pixel, coloured by iterationcolor.shader
+layout(r32f, binding = 0) uniform writeonly image2D iterationBuffer;
+
+// tiles are handed out in order to whichever workgroup asks next
+// note: llvmpipe caps the total trip count of nested loops, so at several
+// thousand iterations it can cut tiles short here; escapetime_chunked.shader
+// keeps each pass short and is the one to use for high counts on llvmpipe
+layout(std430, binding = 0) buffer TileQueue {
+    uint nextTile;
+};
+
+// escape counts in equal bins over [0, iterations), the last slot counts pixels
+// that hit the cap; read back a few frames later by IterationHistogram
+layout(std430, binding = 4) buffer Histogram {
+    uint histogram[HISTOGRAM_BINS + 1];
+};
+
+uniform ivec2 resolution = ivec2(1280, 720);
+uniform vec2 location = vec2(0, 0);
+uniform vec2 mousePos = vec2(0, 0);
+uniform bool juliaMode = false;
+uniform float zoom = 2.0;
+uniform int iterations = 200;
+
+// two slots used in turn, so invocation 0 can fetch the next tile while the
+// others are still writing out the current one
+shared uint s_Tile[2];
+shared float s_Staging[TILE_SIZE * TILE_SIZE];
+// binned in shared memory and added to the buffer once per workgroup
+shared uint s_Histogram[HISTOGRAM_BINS + 1];
+
+vec2 iterate(vec2 z)
+{
+#if FRACTAL == 1
+    // burning ship
+    float temp = abs(z.x);
+    z.x = abs(z.x * z.x) - abs(z.y * z.y);
+    z.y = 2.0 * temp * abs(z.y);
+#elif FRACTAL == 2
+    // tricorn
+    z = vec2(z.x, -z.y);
+    float temp = z.x;
+    z.x = z.x * z.x - z.y * z.y;
+    z.y = 2.0 * temp * z.y;
+#else
+    // mandelbrot
+    float temp = z.x;
+    z.x = z.x * z.x - z.y * z.y;
+    z.y = 2.0 * temp * z.y;
+#endif
+    return z;
+}
+
+void addToHistogram(int iters)
+{
+    uint bin = iters >= iterations ? uint(HISTOGRAM_BINS) : uint(iters * HISTOGRAM_BINS / iterations);
+    atomicAdd(s_Histogram[bin], 1u);
+}
+
+float escapetime(vec2 point) {
+    vec2 z;
+
+    if (juliaMode) { //z is point - julia set
+        z = point;
+        point = mousePos;
+    }
+    else { //z starts at 0 and is squared, with point added on - mandelbrot set
+        z = vec2(0.0);
+    }
+
+    //calculate iterationts until it escapes
+    int iters = 0;
+    for (; iters < iterations; ++iters)
+    {
+        z = iterate(z) + point;
+        if (dot(z, z) > 4.0) break;
+    }
+
+    addToHistogram(iters);
+    return iters - log(log(dot(z, z)) / log(B)) / log(2.);
+}
+
+// same mapping as the fragment shaders, evaluated at the pixel centre
+vec2 pixelToPlane(ivec2 pixel)
+{
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(resolution);
+    float ratio = float(resolution.x) / resolution.y;
+    uv.x *= ratio;
+    uv -= vec2(ratio / 2, 0.5);
+
+    uv *= zoom;
+    uv += location;
+
+    uv.y *= -1;
+    return uv;
+}
+
+// gathers the even bits of an 8 bit Morton index into a 4 bit coordinate
+uint compactBits(uint v)
+{
+    v &= 0x55u;
+    v = (v | (v >> 1u)) & 0x33u;
+    v = (v | (v >> 2u)) & 0x0Fu;
+    return v;
+}
+
+void main()
+{
+    ivec2 tiles = (resolution + TILE_SIZE - 1) / TILE_SIZE;
+    uint numTiles = uint(tiles.x * tiles.y);
+
+    // invocations walk the tile in Z order so each hardware wave covers a compact
+    // block instead of two long rows, which keeps its escape counts similar
+    uint index = gl_LocalInvocationIndex;
+    ivec2 local = ivec2(compactBits(index), compactBits(index >> 1u));
+    uint stagingIndex = uint(local.y) * TILE_SIZE + uint(local.x);
+
+    if (index <= uint(HISTOGRAM_BINS)) {
+        s_Histogram[index] = 0u;
+    }
+
+    // persistent workgroups: keep pulling tiles until the queue runs dry
+    uint slot = 0u;
+    if (index == 0u) {
+        s_Tile[slot] = atomicAdd(nextTile, 1u);
+    }
+    barrier();
+    uint tile = s_Tile[slot];
+
+    while (tile < numTiles) {
+        ivec2 origin = ivec2(int(tile) % tiles.x, int(tile) / tiles.x) * TILE_SIZE;
+        ivec2 pixel = origin + local;
+
+        float value = 0.0;
+        if (all(lessThan(pixel, resolution))) {
+            value = escapetime(pixelToPlane(pixel));
+        }
+
+        // stage in shared memory, then write the tile back out in row order
+        s_Staging[stagingIndex] = value;
+        barrier();
+
+        ivec2 outPixel = origin + ivec2(int(index) % TILE_SIZE, int(index) / TILE_SIZE);
+        if (all(lessThan(outPixel, resolution))) {
+            imageStore(iterationBuffer, outPixel, vec4(s_Staging[index]));
+        }
+
+        slot ^= 1u;
+        if (index == 0u) {
+            s_Tile[slot] = atomicAdd(nextTile, 1u);
+        }
+        barrier();
+        tile = s_Tile[slot];
+    }
+
+    // the loop exits on a shared value, so the whole group reaches this together
+    if (index <= uint(HISTOGRAM_BINS) && s_Histogram[index] != 0u) {
+        atomicAdd(histogram[index], s_Histogram[index]);
+    }
+}
@@ -0,0 +1,36 @@
+#shader vertex
+
+#version 330
+
+layout(location = 0) in vec2 aPos;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+
+#shader fragment
+
+#version 330
+
+uniform sampler2D iterationBuffer;
+uniform int iterations = 200;
+uniform vec3 color_1 = vec3(0.5);
+uniform vec3 color_2 = vec3(0.5);
+uniform vec3 color_3 = vec3(1.0);
+uniform vec3 color_4 = vec3(0.0, 0.33, 0.67);
+
+out vec4 FragColor;
+
+vec3 pal(float t) {
+    return color_1 + color_2 * cos(6.28318 * (color_3 * t + color_4));
+}
+
+void main()
+{
+    float sn = texelFetch(iterationBuffer, ivec2(gl_FragCoord.xy), 0).r / iterations;
+
+    vec3 color = pal(fract(6. * sn));
+
+    FragColor = vec4(color, 1.0);
+}
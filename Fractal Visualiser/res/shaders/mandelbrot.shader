@@ -77,6 +77,12 @@ void main()
     // flip vertically
     uv.y *= -1;
 
+#ifdef ITERATION_OUTPUT
+    // the smooth iteration count itself, into an r32f target for the regression check
+    FragColor = vec4(mandelbrot(uv));
+    return;
+#endif
+
     float sn = float(mandelbrot(uv)) / iterations;
 
     vec3 color = pal(fract(6. * sn));
@@ -23,16 +23,70 @@ uniform vec3 color_1 = vec3(0.5);
 uniform vec3 color_2 = vec3(0.5);
 uniform vec3 color_3 = vec3(1.0);
 uniform vec3 color_4 = vec3(0.0, 0.33, 0.67);
-uniform int time;
+uniform float power = 8.0;
+uniform bool showSteps = false;
+// colours hits with the palette from the orbit traps instead of plain white
+uniform bool trapColoring = false;
+
+// quality budget, set per frame from the current quality tier
+uniform int maxSteps = 100;
+uniform int maxShadowSteps = 64;
+uniform float surfaceDist = .0005;
+
+// pixels per side of a cone pre-pass block, 0 when there is no pre-pass
+uniform int coneBlock = 0;
+// written by the CONE_PREPASS build of this shader, one texel per block
+uniform sampler2D coneDepth;
+
+// distance estimates baked over the bounding cube, used while useVolume is set
+uniform bool useVolume = false;
+uniform sampler3D distanceVolume;
+
+// temporal accumulation: sample 0 is the plain image shown while the view
+// moves, after that each frame is one jittered sample averaged into the history
+uniform bool accumulate = false;
+uniform int sampleIndex = 0;
+uniform sampler2D history;
 
 out vec4 FragColor;
 
 // Constants
 #define PI 3.1415925359
 #define TWO_PI 6.2831852
-#define MAX_STEPS 100
 #define MAX_DIST 100.
-#define SURFACE_DIST .01
+// everything outside this sphere is empty, see the threshold in mandelbulb()
+#define BOUND_RADIUS 1.4
+// over-relaxation factor for the primary march, 1 is plain sphere tracing
+#define OVER_RELAX 1.6
+// accumulated frames only: area light size, ambient occlusion reach and strength
+#define LIGHT_RADIUS 0.4
+#define AO_RADIUS 0.3
+#define AO_STEPS 16
+#define AO_STRENGTH 0.5
+
+// march steps taken by this pixel, shown when showSteps is set
+int primarySteps = 0;
+int shadowSteps = 0;
+
+// set in main() when this frame is one of the accumulated samples
+bool stochastic = false;
+
+// PCG hash, seeded per pixel and per sample in main()
+uint rngState = 1u;
+
+float Random()
+{
+    rngState = rngState * 747796405u + 2891336453u;
+    uint word = ((rngState >> ((rngState >> 28u) + 4u)) ^ rngState) * 277803737u;
+    return float((word >> 22u) ^ word) / 4294967295.0;
+}
+
+vec3 RandomUnitVector()
+{
+    float z = Random() * 2.0 - 1.0;
+    float a = Random() * TWO_PI;
+    return vec3(sqrt(1.0 - z * z) * vec2(cos(a), sin(a)), z);
+}
 
 mat3 camera(vec3 cameraPos, vec3 lookAtPoint) {
     vec3 cd = normalize(lookAtPoint - cameraPos); // camera direction
@@ -42,21 +96,98 @@ mat3 camera(vec3 cameraPos, vec3 lookAtPoint) {
     return mat3(-cr, cu, -cd);
 }
 
-float mandelbulb(vec3 pos)
+vec2 csquare(vec2 a)
 {
-    float thres = length(pos) - 1.2;
-    if (thres > 0.2) {
-        return thres;
+    return vec2(a.x * a.x - a.y * a.y, 2.0 * a.x * a.y);
+}
+
+vec2 cmul(vec2 a, vec2 b)
+{
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+// Integer powers without transcendentals. With theta = acos(z / r) and
+// phi = atan(y, x), and rho = length(xy):
+//   (z + i rho)^n = r^n (cos(n theta) + i sin(n theta))
+//   (x + i y)^n  = rho^n (cos(n phi) + i sin(n phi))
+// so the triplex power is a pair of complex powers, matching the polar form.
+float mandelbulbPower8(vec3 pos)
+{
+    vec3 z = pos;
+    vec3 c = pos;
+
+    float dr = 1.0;
+    float r = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+        float r2 = dot(z, z);
+        r = sqrt(r2);
+        if (r > 2.0) { break; }
+
+        float rho2 = dot(z.xy, z.xy);
+
+        vec2 t = vec2(z.z, sqrt(rho2));
+        t = csquare(csquare(csquare(t)));
+
+        vec2 p = csquare(csquare(csquare(z.xy)));
+        float rho8 = rho2 * rho2;
+        rho8 *= rho8;
+        p = rho8 > 0.0 ? p / rho8 : vec2(1.0, 0.0);
+
+        // derivate, r^7
+        dr = 8.0 * r2 * r2 * r2 * r * dr + 1.0;
+
+        z = vec3(t.y * p, t.x) + c;
+    }
+
+    return 0.5 * log(r) * r / dr;
+}
+
+float mandelbulbInteger(vec3 pos, int n)
+{
+    vec3 z = pos;
+    vec3 c = pos;
+
+    float dr = 1.0;
+    float r = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+        r = length(z);
+        if (r > 2.0) { break; }
+
+        // both complex powers by repeated squaring in the same loop
+        vec2 ta = vec2(z.z, length(z.xy));
+        vec2 pa = z.xy;
+        vec2 t = vec2(1.0, 0.0);
+        vec2 p = vec2(1.0, 0.0);
+        for (int k = n; k > 0; k >>= 1) {
+            if ((k & 1) != 0) {
+                t = cmul(t, ta);
+                p = cmul(p, pa);
+            }
+            ta = csquare(ta);
+            pa = csquare(pa);
+        }
+
+        // |t| is r^n and |p| is rho^n, so no separate real powers are needed
+        float rn = length(t);
+        float rhoN = length(p);
+        p = rhoN > 0.0 ? p / rhoN : vec2(1.0, 0.0);
+
+        dr = float(n) * rn / r * dr + 1.0;
+
+        z = vec3(t.y * p, t.x) + c;
     }
 
+    return 0.5 * log(r) * r / dr;
+}
+
+// fractional powers, used while the power is animating
+float mandelbulbTrig(vec3 pos)
+{
     // Zn <- Zn^8 + c
     // Zn' <- 8*Zn^7 + 1    
-    float power = float(time) * 0.005;
     vec3 z = pos;
     vec3 c = pos;
 
-    vec3 orbit_trap = vec3(1e20);
-
     float dr = 1.0;
     float r = 0.0;
     for (int i = 0; i < iterations; ++i) {
@@ -77,15 +208,53 @@ float mandelbulb(vec3 pos)
         // to cartesian
         z = zr * vec3(sin(theta) * cos(phi), sin(phi) * sin(theta), cos(theta));
         z += c;
-
-        orbit_trap.x = min(pow(abs(z.z), 0.1), orbit_trap.x);
-        orbit_trap.y = min(abs(z.x) - 0.15, orbit_trap.y);
-        orbit_trap.z = min(length(z), orbit_trap.z);
     }
 
     return 0.5 * log(r) * r / dr;
 }
 
+float mandelbulb(vec3 pos)
+{
+    float thres = length(pos) - 1.2;
+    if (thres > BOUND_RADIUS - 1.2) {
+        return thres;
+    }
+
+    if (power == 8.0) {
+        return mandelbulbPower8(pos);
+    }
+    if (power == floor(power) && power >= 2.0) {
+        return mandelbulbInteger(pos, int(power));
+    }
+    return mandelbulbTrig(pos);
+}
+
+// Shading estimator, run once per hit rather than in every march step. The
+// orbit is followed to escape, keeping how close it came to three traps:
+// x the z = 0 plane (softened), y the x = 0.15 planes and z the origin.
+vec3 OrbitTrap(vec3 pos)
+{
+    vec3 z = pos;
+    vec3 trap = vec3(1e20);
+    for (int i = 0; i < iterations; ++i) {
+        float r = length(z);
+        if (r > 2.0) { break; }
+
+        float theta = acos(z.z / r) * power;
+        float phi = atan(z.y, z.x) * power;
+        z = pow(r, power) * vec3(sin(theta) * cos(phi), sin(phi) * sin(theta), cos(theta)) + pos;
+
+        trap.x = min(trap.x, pow(abs(z.z), 0.1));
+        trap.y = min(trap.y, abs(z.x) - 0.15);
+        trap.z = min(trap.z, length(z));
+    }
+    return trap;
+}
+
+vec3 pal(float t) {
+    return color_1 + color_2 * cos(6.28318 * (color_3 * t + color_4));
+}
+
 float GetDist(vec3 p)
 {
     /*
@@ -98,35 +267,254 @@ float GetDist(vec3 p)
     return mandelbulb(p);
 }
 
+// Dual numbers for the normals: x holds the value and yzw its gradient with
+// respect to the sample position, so one pass of the iteration gives both.
+vec4 dmul(vec4 a, vec4 b)
+{
+    return vec4(a.x * b.x, a.x * b.yzw + b.x * a.yzw);
+}
+
+vec4 ddiv(vec4 a, vec4 b)
+{
+    return vec4(a.x / b.x, (a.yzw * b.x - a.x * b.yzw) / (b.x * b.x));
+}
+
+vec4 dsqrt(vec4 a)
+{
+    float s = sqrt(a.x);
+    return vec4(s, a.yzw * (0.5 / s));
+}
+
+vec4 dpow(vec4 a, float n)
+{
+    float p = pow(a.x, n - 1.0);
+    return vec4(p * a.x, n * p * a.yzw);
+}
+
+vec4 dsin(vec4 a)
+{
+    return vec4(sin(a.x), cos(a.x) * a.yzw);
+}
+
+vec4 dcos(vec4 a)
+{
+    return vec4(cos(a.x), -sin(a.x) * a.yzw);
+}
+
+vec4 dacos(vec4 a)
+{
+    return vec4(acos(a.x), -a.yzw / sqrt(max(1.0 - a.x * a.x, 1e-12)));
+}
+
+vec4 datan(vec4 y, vec4 x)
+{
+    return vec4(atan(y.x, x.x), (x.x * y.yzw - y.x * x.yzw) / (x.x * x.x + y.x * y.x));
+}
+
+// (re + i im)^2 on dual numbers
+void dcsquare(inout vec4 re, inout vec4 im)
+{
+    vec4 temp = dmul(re, re) - dmul(im, im);
+    im = 2.0 * dmul(re, im);
+    re = temp;
+}
+
+// the escaped orbit's radius grows fastest straight out of the surface, so the
+// normal is the gradient of |z| at the end of the iteration
+vec3 OrbitGradient(vec4 x, vec4 y, vec4 z)
+{
+    return normalize(x.x * x.yzw + y.x * y.yzw + z.x * z.yzw);
+}
+
+// same iteration as mandelbulbPower8
+vec3 NormalPower8(vec3 pos)
+{
+    vec4 x = vec4(pos.x, 1.0, 0.0, 0.0);
+    vec4 y = vec4(pos.y, 0.0, 1.0, 0.0);
+    vec4 z = vec4(pos.z, 0.0, 0.0, 1.0);
+    vec4 cx = x;
+    vec4 cy = y;
+    vec4 cz = z;
+
+    for (int i = 0; i < iterations; ++i) {
+        if (length(vec3(x.x, y.x, z.x)) > 2.0) { break; }
+
+        vec4 rho2 = dmul(x, x) + dmul(y, y);
+
+        vec4 tre = z;
+        vec4 tim = dsqrt(rho2);
+        dcsquare(tre, tim);
+        dcsquare(tre, tim);
+        dcsquare(tre, tim);
+
+        vec4 pre = x;
+        vec4 pim = y;
+        dcsquare(pre, pim);
+        dcsquare(pre, pim);
+        dcsquare(pre, pim);
+
+        vec4 rho8 = dmul(rho2, rho2);
+        rho8 = dmul(rho8, rho8);
+        if (rho8.x > 0.0) {
+            pre = ddiv(pre, rho8);
+            pim = ddiv(pim, rho8);
+        }
+        else {
+            pre = vec4(1.0, 0.0, 0.0, 0.0);
+            pim = vec4(0.0);
+        }
+
+        x = dmul(tim, pre) + cx;
+        y = dmul(tim, pim) + cy;
+        z = tre + cz;
+    }
+
+    return OrbitGradient(x, y, z);
+}
+
+// same iteration as mandelbulbTrig, used for every power but 8
+vec3 NormalTrig(vec3 pos)
+{
+    vec4 x = vec4(pos.x, 1.0, 0.0, 0.0);
+    vec4 y = vec4(pos.y, 0.0, 1.0, 0.0);
+    vec4 z = vec4(pos.z, 0.0, 0.0, 1.0);
+    vec4 cx = x;
+    vec4 cy = y;
+    vec4 cz = z;
+
+    for (int i = 0; i < iterations; ++i) {
+        vec4 r = dsqrt(dmul(x, x) + dmul(y, y) + dmul(z, z));
+        if (r.x > 2.0) { break; }
+
+        vec4 theta = power * dacos(ddiv(z, r));
+        vec4 phi = power * datan(y, x);
+        vec4 zr = dpow(r, power);
+
+        vec4 sinTheta = dsin(theta);
+        x = dmul(zr, dmul(sinTheta, dcos(phi))) + cx;
+        y = dmul(zr, dmul(dsin(phi), sinTheta)) + cy;
+        z = dmul(zr, dcos(theta)) + cz;
+    }
+
+    return OrbitGradient(x, y, z);
+}
+
 vec3 GetNormal(vec3 p)
 {
-    float d = GetDist(p); // Distance
-    vec2 e = vec2(.01, 0); // Epsilon
-    vec3 n = d - vec3(
-        GetDist(p - e.xyy),
-        GetDist(p - e.yxy),
-        GetDist(p - e.yyx));
+    // outside the bound the estimate is a sphere
+    if (length(p) > BOUND_RADIUS) {
+        return normalize(p);
+    }
+    return power == 8.0 ? NormalPower8(p) : NormalTrig(p);
+}
+
+// distances along the ray where it enters and leaves the bounding sphere,
+// x > y when the ray misses it
+vec2 BoundingSphere(vec3 ro, vec3 rd)
+{
+    float b = dot(ro, rd);
+    float c = dot(ro, ro) - BOUND_RADIUS * BOUND_RADIUS;
+    float h = b * b - c;
+    if (h < 0.0) {
+        return vec2(1.0, -1.0);
+    }
+    h = sqrt(h);
+    return vec2(max(-b - h, 0.0), -b + h);
+}
 
-    return normalize(n);
+// half the width of a pixel at distance t, the surface is hit once the
+// distance estimate drops below it
+float PixelEpsilon(float t)
+{
+    return max(surfaceDist, 0.5 * t / float(resolution.y));
 }
 
+// baked distance, trilinear between voxel centres. Interpolation can be out by
+// up to half a voxel diagonal, so that much is taken off to keep the step safe
+float VolumeDist(vec3 p, float margin)
+{
+    vec3 uvw = p / (2.0 * BOUND_RADIUS) + 0.5;
+    return texture(distanceVolume, uvw).r - margin;
+}
+
+// over-relaxed sphere tracing (Keinert et al. 2014): steps are stretched by
+// OVER_RELAX, and when the unbounding spheres of two steps stop overlapping
+// the step is undone and marching carries on with plain steps.
+// returns MAX_DIST on a miss
 float RayMarch(vec3 ro, vec3 rd)
 {
-    float dO = 0.; //Distane Origin
-    for (int i = 0; i < MAX_STEPS; i++)
+    vec2 bounds = BoundingSphere(ro, rd);
+    if (bounds.x > bounds.y) {
+        return MAX_DIST;
+    }
+
+    float t = bounds.x;
+    if (coneBlock > 0) {
+        ivec2 block = min(ivec2(gl_FragCoord.xy) / coneBlock, textureSize(coneDepth, 0) - 1);
+        t = max(t, texelFetch(coneDepth, block, 0).r);
+        if (t > bounds.y) {
+            return MAX_DIST;
+        }
+    }
+
+    primarySteps = 0;
+    if (useVolume) {
+        // cross empty space on the baked field, then hand over to the exact
+        // estimate a voxel or two out from the surface
+        float voxel = 2.0 * BOUND_RADIUS / float(textureSize(distanceVolume, 0).x);
+        float margin = 0.87 * voxel;
+        for (; primarySteps < maxSteps; primarySteps++)
+        {
+            float d = VolumeDist(ro + rd * t, margin);
+            if (d < voxel) {
+                break;
+            }
+            t += d;
+            if (t > bounds.y) {
+                return MAX_DIST;
+            }
+        }
+    }
+
+    float omega = OVER_RELAX;
+    float stepLength = 0.0;
+    float prevRadius = 0.0;
+
+    for (; primarySteps < maxSteps; primarySteps++)
     {
-        vec3 p = ro + rd * dO;
-        float ds = GetDist(p); // ds is Distance Scene
-        dO += ds;
-        if (dO > MAX_DIST || ds < SURFACE_DIST) break;
+        float radius = GetDist(ro + rd * t);
+
+        bool relaxFailed = omega > 1.0 && radius + prevRadius < stepLength;
+        if (relaxFailed) {
+            stepLength -= omega * stepLength;
+            omega = 1.0;
+        }
+        else {
+            stepLength = radius * omega;
+        }
+        prevRadius = radius;
+
+        if (!relaxFailed && radius < PixelEpsilon(t)) {
+            return t;
+        }
+        if (t > bounds.y) {
+            return MAX_DIST;
+        }
+        t += stepLength;
     }
-    return dO;
+
+    // out of steps, treat as a hit only if it got close
+    return prevRadius < 10.0 * PixelEpsilon(t) ? t : MAX_DIST;
 }
 
 float shadow(vec3 ro, vec3 rd, int k)
 {
+    // nothing can occlude past the far side of the bounding sphere
+    float tMax = BoundingSphere(ro, rd).y;
+
     float res = 1.0;
-    for (float t = 0; t < MAX_STEPS; )
+    float t = 0.0;
+    for (shadowSteps = 0; shadowSteps < maxShadowSteps && t < tMax; shadowSteps++)
     {
         float h = GetDist(ro + rd * t);
         if (h < 0.001)
@@ -137,39 +525,125 @@ float shadow(vec3 ro, vec3 rd, int k)
     return res;
 }
 
-float CalculateDiffuseLighting(vec3 p)
+float CalculateDiffuseLighting(vec3 p, vec3 n, float eps)
 {
     // Light (directional diffuse)
     vec3 lightPos = vec3(0, 2.0, -4.0); // Light Position
+    if (stochastic) {
+        // one point on an area light per sample, the penumbra is averaged over frames
+        lightPos += LIGHT_RADIUS * RandomUnitVector();
+    }
     vec3 l = normalize(lightPos - p); // Light Vector
-    vec3 n = GetNormal(p); // Normal Vector
 
     float dif = dot(n, l); // Diffuse light
     dif = clamp(dif, 0., 1.); // Clamp so it doesnt go below 0
 
-    float d = shadow(p + n * SURFACE_DIST * 2., l, 2);
+    float d = shadow(p + n * eps * 2., l, 2);
 
     dif *= d;
 
     return dif;
 }
 
+// one cosine weighted ray per sample, 1 if it gets AO_RADIUS clear of the surface
+float AmbientOcclusion(vec3 p, vec3 n, float eps)
+{
+    vec3 ro = p + n * eps * 2.;
+    vec3 rd = normalize(n + RandomUnitVector());
+
+    float t = 0.0;
+    for (int i = 0; i < AO_STEPS && t < AO_RADIUS; i++)
+    {
+        float h = GetDist(ro + rd * t);
+        if (h < 0.001)
+            return 0.0;
+        t += h;
+    }
+    return 1.0;
+}
+
+#ifdef CONE_PREPASS
+
+// Marches the cone through the rays of one coneBlock x coneBlock block of the
+// full image. At distance t the cone has radius k * t, so a step is safe while
+// the distance estimate beats that radius, and points up to (d - k t) / (1 + k)
+// further along any ray in the cone are inside the empty sphere. The block's
+// rays can all start at the final t.
+void main()
+{
+    vec2 uv = (gl_FragCoord.xy * float(coneBlock) - .5 * resolution.xy) / resolution.y;
+    vec3 ro = vec3(0, 0, 0) + vec3(sin(location.x) * 3, 0.0, cos(location.x) * 3);
+    vec3 lp = vec3(0.0, 0.0, 0.0);
+    vec3 rd = camera(ro, lp) * normalize(vec3(uv, -1));
+
+    // tangent of the half angle out to the block's corner pixels, with some slack
+    float k = 1.1 * 0.7072 * float(coneBlock) / float(resolution.y);
+
+    float t = 0.0;
+    for (int i = 0; i < maxSteps && t < MAX_DIST; i++)
+    {
+        float gap = GetDist(ro + rd * t) - k * t;
+        if (gap < surfaceDist) {
+            break;
+        }
+        t += gap / (1.0 + k);
+    }
+
+    FragColor = vec4(t);
+}
+
+#else
+
 void main()
 {
-    vec2 uv = (gl_FragCoord.xy - .5 * resolution.xy) / resolution.y;
+    // subpixel jitter from the R2 sequence, so successive samples cover the pixel evenly
+    stochastic = accumulate && sampleIndex > 0;
+    vec2 jitter = vec2(0.0);
+    if (stochastic) {
+        jitter = fract(float(sampleIndex) * vec2(0.7548776662, 0.5698402910)) - 0.5;
+        rngState = uint(gl_FragCoord.x) * 1973u + uint(gl_FragCoord.y) * 9277u + uint(sampleIndex) * 26699u;
+    }
+
+    vec2 uv = (gl_FragCoord.xy + jitter - .5 * resolution.xy) / resolution.y;
     vec3 ro = vec3(0, 0, 0) + vec3(sin(location.x) * 3, 0.0, cos(location.x) * 3); // Ray Origin/ Camera
     vec3 lp = vec3(0.0, 0.0, 0.0);
     vec3 rd = camera(ro, lp) * normalize(vec3(uv, -1)); // ray direction
 
     float d = RayMarch(ro, rd); // Distance
 
+    vec3 color = vec3(0.0);
+    if (d < MAX_DIST) {
+        vec3 p = ro + rd * d;
+        vec3 n = GetNormal(p);
+        float eps = PixelEpsilon(d);
+        float diff = CalculateDiffuseLighting(p, n, eps);
+        float ambientStrength = 1.0;
+        vec3 ambient = ambientStrength * vec3(1.0 ,1.0, 1.0);
+        if (trapColoring) {
+            vec3 trap = OrbitTrap(p);
+            ambient *= pal(trap.z + 0.5 * trap.x);
+        }
+        color = ambient * vec3(diff);
+
+        if (stochastic) {
+            color *= 1.0 - AO_STRENGTH * (1.0 - AmbientOcclusion(p, n, eps));
+        }
+    }
 
-    vec3 p = ro + rd * d;
-    float diff = CalculateDiffuseLighting(p);
-    float ambientStrength = 1.0;
-    vec3 ambient = ambientStrength * vec3(1.0 ,1.0, 1.0);
-    vec3 color = ambient * vec3(diff);
+    if (showSteps) {
+        // blue to red through green as the pixel uses up its step budgets
+        float cost = float(primarySteps + shadowSteps) / float(maxSteps + maxShadowSteps);
+        color = clamp(vec3(2.0 * cost - 0.5, 1.0 - abs(2.0 * cost - 1.0), 1.5 - 2.0 * cost), 0.0, 1.0);
+    }
+
+    // the average starts from sample 1, sample 0 is only there to show
+    if (stochastic && sampleIndex > 1) {
+        vec3 previous = texelFetch(history, ivec2(gl_FragCoord.xy), 0).rgb;
+        color = mix(previous, color, 1.0 / float(sampleIndex));
+    }
 
     // Set the output color
     FragColor = vec4(color, 1.0);
-} 
\ No newline at end of file
+} 
+
+#endif
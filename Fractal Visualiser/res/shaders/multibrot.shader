@@ -0,0 +1,102 @@
+#shader vertex
+
+#version 330
+
+layout(location = 0) in vec2 aPos;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+
+#shader fragment
+
+#version 330
+
+// MultibrotShaders injects these: MULTICORN conjugates z before raising it, and
+// for a whole power a powerChain(z) written out as squarings and multiplies,
+// with POWER_CHAIN defined; without one the polar form below is used
+
+#define B 4.
+
+uniform ivec2 resolution = ivec2(1280, 720);
+uniform vec2 location = vec2(0, 0);
+uniform vec2 mousePos = vec2(0, 0);
+uniform bool juliaMode = false;
+uniform float zoom = 2.0;
+uniform int iterations = 200;
+// n, named apart from the Mandelbulb's power which the application sets every frame
+uniform float exponent = 3.0;
+uniform vec3 color_1 = vec3(0.5);
+uniform vec3 color_2 = vec3(0.5);
+uniform vec3 color_3 = vec3(1.0);
+uniform vec3 color_4 = vec3(0.0, 0.33, 0.67);
+out vec4 FragColor;
+
+#ifndef POWER_CHAIN
+vec2 powerChain(vec2 z)
+{
+    float squared = dot(z, z);
+    if (squared == 0.0) return z;
+    float radius = pow(squared, 0.5 * exponent);
+    float angle = atan(z.y, z.x) * exponent;
+    return radius * vec2(cos(angle), sin(angle));
+}
+#endif
+
+float multibrot(vec2 point) {
+    vec2 z;
+
+    if (juliaMode) { //z is point - julia set
+        z = point;
+        point = mousePos;
+
+    }
+    else { //z starts at 0 and is raised to the power, with point added on - multibrot set
+        z = vec2(0.0);
+    }
+
+    //calculate iterationts until it escapes
+    int iters = 0;
+    for (; iters < iterations; ++iters)
+    {
+#ifdef MULTICORN
+        z.y = -z.y;
+#endif
+        z = powerChain(z) + point;
+        if (dot(z, z) > 4.0) break;
+    }
+
+    return iters - log(log(dot(z, z)) / log(B)) / log(exponent);
+}
+
+vec3 pal(float t) {
+    return color_1 + color_2 * cos(6.28318 * (color_3 * t + color_4));
+}
+
+void main()
+{
+
+    vec2 uv = gl_FragCoord.xy / vec2(resolution);
+    float ratio = float(resolution.x) / resolution.y;
+    uv.x *= ratio;
+    uv -= vec2(ratio / 2, 0.5); //move center of mandelbrot to center of screen
+
+    uv *= zoom; //zoom
+    uv += location; // position
+
+    // flip vertically
+    uv.y *= -1;
+
+#ifdef ITERATION_OUTPUT
+    // the smooth iteration count itself, into an r32f target for the regression check
+    FragColor = vec4(multibrot(uv));
+    return;
+#endif
+
+    float sn = float(multibrot(uv)) / iterations;
+
+    vec3 color = pal(fract(6. * sn));
+
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#shader vertex
+
+#version 330
+
+layout(location = 0) in vec2 aPos;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+
+#shader fragment
+
+#version 330
+
+// matches NewtonPolynomial::c_MaxDegree
+#define MAX_DEGREE 8
+// matches Newton::c_Tolerance
+#define TOLERANCE 1.0e-3
+
+uniform ivec2 resolution = ivec2(1280, 720);
+uniform vec2 location = vec2(0, 0);
+uniform float zoom = 2.0;
+uniform int iterations = 200;
+uniform vec3 color_1 = vec3(0.5);
+uniform vec3 color_2 = vec3(0.5);
+uniform vec3 color_3 = vec3(1.0);
+uniform vec3 color_4 = vec3(0.0, 0.33, 0.67);
+
+// lowest power first, and the roots the CPU found for them
+uniform int degree = 3;
+uniform vec2 coefficients[MAX_DEGREE + 1];
+uniform int rootCount = 0;
+uniform vec2 roots[MAX_DEGREE];
+out vec4 FragColor;
+
+vec2 compmul(vec2 a, vec2 b)
+{
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+// Newton's method from point; returns the steps taken, with root set to the
+// root it came within TOLERANCE of, or -1 if it never did
+int newton(vec2 z, out int root) {
+    for (int iters = 0; iters < iterations; ++iters)
+    {
+        // checking the known roots is the early out, most points need a handful of steps
+        for (int i = 0; i < rootCount; ++i)
+        {
+            vec2 d = z - roots[i];
+            if (dot(d, d) < TOLERANCE * TOLERANCE) {
+                root = i;
+                return iters;
+            }
+        }
+
+        // p and p' together by Horner's scheme
+        vec2 p = coefficients[degree];
+        vec2 dp = vec2(0.0);
+        for (int i = degree - 1; i >= 0; --i)
+        {
+            dp = compmul(dp, z) + p;
+            p = compmul(p, z) + coefficients[i];
+        }
+
+        float magnitude = dot(dp, dp);
+        if (magnitude == 0.0) break;
+        z -= vec2(p.x * dp.x + p.y * dp.y, p.y * dp.x - p.x * dp.y) / magnitude;
+    }
+
+    root = -1;
+    return iterations;
+}
+
+vec3 pal(float t) {
+    return color_1 + color_2 * cos(6.28318 * (color_3 * t + color_4));
+}
+
+void main()
+{
+
+    vec2 uv = gl_FragCoord.xy / vec2(resolution);
+    float ratio = float(resolution.x) / resolution.y;
+    uv.x *= ratio;
+    uv -= vec2(ratio / 2, 0.5); //move origin to center of screen
+
+    uv *= zoom; //zoom
+    uv += location; // position
+
+    // flip vertically
+    uv.y *= -1;
+
+    int root;
+    int iters = newton(uv, root);
+
+    // each basin takes its own stretch of the palette, darkening with the steps it took
+    if (root < 0) {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec3 color = pal(float(root) / float(rootCount)) * max(pow(0.92, float(iters)), 0.15);
+
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
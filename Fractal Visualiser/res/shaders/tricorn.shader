@@ -78,6 +78,12 @@ void main()
     // flip vertically
     uv.y *= -1;
 
+#ifdef ITERATION_OUTPUT
+    // the smooth iteration count itself, into an r32f target for the regression check
+    FragColor = vec4(tricorn(uv));
+    return;
+#endif
+
     float sn = float(tricorn(uv)) / iterations;
 
     vec3 color = pal(fract(6. * sn));
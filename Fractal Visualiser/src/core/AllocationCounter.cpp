@@ -0,0 +1,195 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace {
+	// plain thread_local integers need no constructor, so they are safe to
+	// touch from operator new however early a thread allocates
+	thread_local uint64_t t_Allocations = 0;
+	thread_local uint64_t t_Bytes = 0;
+	thread_local int t_ExemptDepth = 0;
+
+	std::atomic<uint64_t> s_TotalAllocations{ 0 };
+
+	void Record(std::size_t size)
+	{
+		s_TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+		if (t_ExemptDepth > 0)
+			return;
+		t_Allocations++;
+		t_Bytes += size;
+	}
+
+	void* Allocate(std::size_t size)
+	{
+		Record(size);
+		// new has to hand back a unique pointer even for zero bytes
+		return std::malloc(size ? size : 1);
+	}
+
+#ifdef __cpp_aligned_new
+	// for types aligned past what malloc guarantees; alignment is a power of two of at least a pointer's size
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		Record(size);
+#ifdef _MSC_VER
+		return _aligned_malloc(size ? size : 1, static_cast<std::size_t>(alignment));
+#else
+		void* pointer = nullptr;
+		return posix_memalign(&pointer, static_cast<std::size_t>(alignment), size ? size : 1) == 0 ? pointer : nullptr;
+#endif
+	}
+
+	// _aligned_malloc memory can not go to free
+	void FreeAligned(void* pointer)
+	{
+#ifdef _MSC_VER
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+#endif
+}
+
+uint64_t AllocationCounter::GetThreadAllocations()
+{
+	return t_Allocations;
+}
+
+uint64_t AllocationCounter::GetThreadBytes()
+{
+	return t_Bytes;
+}
+
+uint64_t AllocationCounter::GetTotalAllocations()
+{
+	return s_TotalAllocations.load(std::memory_order_relaxed);
+}
+
+AllocationCounter::Exempt::Exempt()
+{
+	t_ExemptDepth++;
+}
+
+AllocationCounter::Exempt::~Exempt()
+{
+	t_ExemptDepth--;
+}
+
+// replacements for the global allocation functions, every new in the program comes through here
+
+void* operator new(std::size_t size)
+{
+	void* pointer = Allocate(size);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+#ifdef __cpp_aligned_new
+// the C++17 aligned forms, which alignas types past 16 bytes call instead
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	void* pointer = AllocateAligned(size, alignment);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(pointer);
+}
+#endif
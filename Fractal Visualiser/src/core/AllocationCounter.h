@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts every call to the global operator new, which AllocationCounter.cpp
+// replaces. Counts are kept per thread, so the frame loop can measure what it
+// allocated without the background bakes getting in the way, and a total is
+// kept for all threads together.
+//
+// ImGui, libpng and the GL driver allocate with malloc, so only the program's
+// own C++ allocations show up here.
+class AllocationCounter {
+public:
+	// allocations and bytes asked for on the calling thread, outside Exempt scopes
+	static uint64_t GetThreadAllocations();
+	static uint64_t GetThreadBytes();
+	// every thread, Exempt scopes included
+	static uint64_t GetTotalAllocations();
+
+	// allocations made on this thread while one is alive are left out of its
+	// count; for one-off work that has to allocate, such as saving a screenshot
+	class Exempt {
+	public:
+		Exempt();
+		~Exempt();
+		Exempt(const Exempt&) = delete;
+		Exempt& operator=(const Exempt&) = delete;
+	};
+};
@@ -9,16 +9,24 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include <core/AllocationCounter.h>
+#include <core/PngWriter.h>
+#include <core/Trace.h>
 #include <core/Window.h>
+#include <cpu/Newton.h>
+#include <renderer/GLState.h>
+#include <renderer/GL43.h>
 #include <vertex/IndexBuffer.h>
 #include <vertex/VertexArray.h>
 #include <vertex/VertexBufferLayout.h>
 #include <vertex/VertexBuffer.h>
 
-#include <libpng16/png.h>
-
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
-#include <sstream>
 
 const unsigned int SCREEN_WIDTH = 1280;
 const unsigned int SCREEN_HEIGHT = 720;
@@ -54,6 +62,7 @@ T Application::LinearInterpolate(int x, int width, T minR, T maxR) {
 void Application::Run()
 {
 	srand(static_cast<unsigned int> (time(NULL)));
+	Trace::SetThreadName("Main");
 
 	if (!glfwInit()) {
 		std::cout << "Failed to intialise GLFW! Aborting..." << std::endl;
@@ -73,6 +82,13 @@ void Application::Run()
 		std::exit(-1);
 	}
 
+	// optional compute backend
+	// ------------------------
+	if (GL43::Load((GLADloadproc)glfwGetProcAddress)) {
+		m_ComputeRenderer = std::make_unique<ComputeRenderer>();
+		m_isComputeAvailable = m_ComputeRenderer->IsValid();
+	}
+
 	// GLFW callback functions
 	// -----------------------
 	glfwSetFramebufferSizeCallback(p_Window, Application::framebuffer_size_callback);
@@ -94,8 +110,34 @@ void Application::Run()
 	m_MandelbulbShader = Shader("res/shaders/mandelbulb.shader");
 	m_MandelbulbShader.InitShader();
 
+	m_NewtonShader = Shader("res/shaders/newton.shader");
+	m_NewtonShader.InitShader();
+	UpdateNewtonPolynomial();
+
+	m_ConePrepass = std::make_unique<ConePrepass>();
+	m_isConePrepassOn = m_ConePrepass->IsValid();
+
+	m_DistanceVolume = std::make_unique<DistanceVolume>();
+	m_AccumulationBuffer = std::make_unique<AccumulationBuffer>(SCREEN_WIDTH, SCREEN_HEIGHT);
+	m_QualityController = std::make_unique<QualityController>();
+	m_IterationController = std::make_unique<IterationController>();
+	m_ScaledTarget = std::make_unique<Framebuffer>(SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGBA8);
+
+	m_Profiler = std::make_unique<Profiler>();
+	m_FrameSection = m_Profiler->AddSection("Frame", Profiler::Clock::CPU);
+	m_InputSection = m_Profiler->AddSection("Input", Profiler::Clock::CPU);
+	m_CheckUISection = m_Profiler->AddSection("Check UI", Profiler::Clock::CPU);
+	m_SubmitSection = m_Profiler->AddSection("Submit Fractal", Profiler::Clock::CPU);
+	m_ImGuiSection = m_Profiler->AddSection("ImGui", Profiler::Clock::CPU);
+	m_SwapSection = m_Profiler->AddSection("Swap", Profiler::Clock::CPU);
+	m_FractalGpuSection = m_Profiler->AddSection("Fractal", Profiler::Clock::GPU);
+	m_UpscaleGpuSection = m_Profiler->AddSection("Upscale", Profiler::Clock::GPU);
+	m_ImGuiGpuSection = m_Profiler->AddSection("ImGui", Profiler::Clock::GPU);
+
 	p_SelectedShader = &m_MandelbulbShader;
 	p_SelectedShader->Bind();
+	glUniform1i(m_MandelbulbShader.GetLocation("distanceVolume"), DistanceVolume::c_TextureUnit);
+	glUniform1i(m_MandelbulbShader.GetLocation("history"), AccumulationBuffer::c_TextureUnit);
 
 	UpdateShaderUniformLocations();
 
@@ -123,16 +165,44 @@ void Application::Run()
 	ImGui_ImplOpenGL3_Init("#version 330");
 
 	int frames = 0;
-	unsigned int frameLoc = glGetUniformLocation(m_ShaderID, "time");
 
 	// application loop
 	// ---------------
 	while (!glfwWindowShouldClose(p_Window)) {
 
+		uint64_t frameStartAllocations = AllocationCounter::GetThreadAllocations();
+		GLState::BeginFrame();
+		m_Profiler->Begin(m_FrameSection);
+
+		// GPU times come back a few frames late, the fractal's steer the quality budget;
+		// the render thread times its own frames
+		m_Profiler->Update();
+		Profiler::GpuResult renderThreadResult;
+		const Profiler::GpuResult* fractalResults = &renderThreadResult;
+		int fractalResultCount = 0;
+		if (m_RenderThread)
+			fractalResultCount = m_RenderThread->GetLatest(renderThreadResult.milliseconds, renderThreadResult.tag) ? 1 : 0;
+		else
+			fractalResultCount = m_Profiler->GetResults(m_FractalGpuSection, fractalResults);
+		for (int i = 0; i < fractalResultCount; i++) {
+			QualityTier tier = static_cast<QualityTier>(fractalResults[i].tag);
+			m_QualityController->AddMeasurement(fractalResults[i].milliseconds, tier);
+			if (tier == QualityTier::Final)
+				m_IterationController->AddFrameTime(fractalResults[i].milliseconds);
+		}
+
 		// input handling
+		m_Profiler->Begin(m_InputSection);
 		ProcessInput();
+		m_Profiler->End(m_InputSection);
 		frames++;
-		glUniform1i(frameLoc, frames);
+		if (m_isBulbPowerAnimated)
+			m_BulbPower = frames * 0.005f;
+		glUniform1f(m_PowerLoc, m_BulbPower);
+		glUniform1f(m_ExponentLoc, m_MultibrotPower);
+		glUniform1i(m_ShowStepsLoc, m_isBulbStepViewOn);
+		glUniform1i(m_TrapColoringLoc, m_isBulbTrapColoringOn);
+		glUniform1i(m_ConeBlockLoc, m_isConePrepassOn ? m_ConeBlockSize : 0);
 
 		// render
 		// ------
@@ -151,12 +221,80 @@ void Application::Run()
 		m_MinI = -0.5f * m_Zoom - m_Location.y;
 		m_MaxI = 0.5f * m_Zoom - m_Location.y;
 
-		// draw quad to render fractal too - main framebuffer
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		// pick this frame's quality budget, and below full size draw offscreen
+		bool isViewChanging = HasViewChanged();
+		m_QualityController->Update(isViewChanging, glfwGetTime());
+		if (m_isAutoIterationsOn && FractalParams::IsAutoIterated(p_SelectedFractal))
+			UpdateAutoIterations(isViewChanging);
+		FractalParams params = GetFractalParams();
+		int windowWidth = params.width;
+		int windowHeight = params.height;
+		ApplyQualityBudget(params);
+
+		if (m_BuddhabrotRenderer && p_SelectedFractal != FRACTAL_BUDDHABROT)
+			m_BuddhabrotRenderer->SetPaused(true);
+
+		if (p_SelectedFractal == FRACTAL_BUDDHABROT) {
+			// sampled on the other cores at full size, the window shows what has come in so far
+			m_Profiler->Begin(m_SubmitSection);
+			m_BuddhabrotRenderer->Update(GetFractalParams(), m_isNebulabrotOn, glfwGetTime());
+			m_Profiler->End(m_SubmitSection);
+			m_BuddhabrotRenderer->Present(windowWidth, windowHeight);
+		}
+		else if (m_RenderThread) {
+			// the render thread draws at its own pace, the window shows the newest frame it finished
+			m_Profiler->Begin(m_SubmitSection);
+			m_RenderThread->Submit(GetRenderSnapshot(params));
+			m_Profiler->End(m_SubmitSection);
+			m_RenderThread->Present(windowWidth, windowHeight);
+		}
+		else {
+			const Framebuffer* target = nullptr;
+			if (params.width != windowWidth || params.height != windowHeight) {
+				m_ScaledTarget->Resize(params.width, params.height);
+				m_ScaledTarget->Bind();
+				target = m_ScaledTarget.get();
+			}
+
+			// draw quad to render fractal too - main framebuffer
+			bool isPresented = false;
+			m_Profiler->Begin(m_FractalGpuSection, static_cast<int>(m_QualityController->GetTier()));
+			m_Profiler->Begin(m_SubmitSection);
+			if (m_UseComputeBackend && m_isComputeAvailable && p_SelectedFractal < FRACTAL_MANDELBULB) {
+				m_ComputeRenderer->SetPersistentGroups(m_PersistentGroups);
+				m_ComputeRenderer->SetChunkSize(m_UseChunkedIterations ? m_ChunkSize : 0);
+				m_ComputeRenderer->Render(params, VAO);
+
+				// rebind so uniform updates from the UI and callbacks still land on the fractal shader
+				p_SelectedShader->Bind();
+			}
+			else if (p_SelectedShader == &m_MandelbulbShader) {
+				isPresented = RenderMandelbulb(params, target, windowWidth, windowHeight, VAO);
+			}
+			else {
+				p_SelectedShader->Bind();
+				VAO.Bind();
+				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			}
+			m_Profiler->End(m_SubmitSection);
+			m_Profiler->End(m_FractalGpuSection);
+
+			if (target) {
+				Framebuffer::BindDefault(windowWidth, windowHeight);
+				if (!isPresented) {
+					m_Profiler->Begin(m_UpscaleGpuSection);
+					GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, target->GetID());
+					glBlitFramebuffer(0, 0, params.width, params.height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+					GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+					m_Profiler->End(m_UpscaleGpuSection);
+				}
+			}
+		}
 
 		// ImGui menu
 		// ----------
 
+		m_Profiler->Begin(m_ImGuiSection);
 		if (m_shouldRenderGUI) {
 
 			ImGui::SetNextWindowSize({ 0,0 });
@@ -164,8 +302,70 @@ void Application::Run()
 			ImGui::Begin("Control Menu");
 			m_isFractalSelectorUsed = ImGui::Combo("Fractals", &p_SelectedFractal, m_FractalOptions, c_NumFractals);
 			m_isIterationsSliderUsed = ImGui::SliderInt("Iterations", &m_Iterations, 0, 10000);
+			if (FractalParams::IsAutoIterated(p_SelectedFractal)) {
+				ImGui::Checkbox("Auto Iterations", &m_isAutoIterationsOn);
+				if (m_isAutoIterationsOn) {
+					float ceiling = m_IterationController->GetCeilingMilliseconds();
+					if (ImGui::SliderFloat("Max Fractal Time (ms)", &ceiling, 5.0f, 200.0f))
+						m_IterationController->SetCeilingMilliseconds(ceiling);
+					ImGui::Text("%s", m_IterationController->GetStatus());
+				}
+			}
 			m_isJuliaModeCheckboxUsed = ImGui::Checkbox("Julia Set Mode", &m_isJuliaMode);
 
+			if (p_SelectedFractal == FRACTAL_MULTIBROT || p_SelectedFractal == FRACTAL_MULTICORN) {
+				m_isMultibrotPowerUsed = ImGui::SliderFloat("Multibrot Power", &m_MultibrotPower, 1.5f, static_cast<float>(ComplexPower::c_MaxChainPower));
+				m_isMultibrotPowerUsed |= ImGui::Checkbox("Whole Powers", &m_isWholePowerOn);
+				if (m_isWholePowerOn)
+					m_MultibrotPower = std::max(std::round(m_MultibrotPower), 2.0f);
+
+				int chainPower = ComplexPower::GetChainPower(m_MultibrotPower);
+				if (chainPower > 0)
+					ImGui::Text("z^%d: %d squarings and %d multiplies", chainPower, ComplexPower::CountSquarings(chainPower), ComplexPower::CountMultiplies(chainPower));
+				else
+					ImGui::Text("Polar form: pow, atan, cos and sin every iteration");
+			}
+
+			if (p_SelectedFractal == FRACTAL_NEWTON) {
+				m_isNewtonPolynomialUsed = ImGui::SliderInt("Degree", &m_NewtonPolynomial.degree, 2, NewtonPolynomial::c_MaxDegree);
+				for (int i = m_NewtonPolynomial.degree; i >= 0; i--) {
+					char label[16];
+					snprintf(label, sizeof(label), "z^%d", i);
+					m_isNewtonPolynomialUsed |= ImGui::DragFloat2(label, &m_NewtonPolynomial.coefficients[i].x, 0.01f);
+				}
+				ImGui::Text("%d roots:", m_NewtonPolynomial.rootCount);
+				for (int i = 0; i < m_NewtonPolynomial.rootCount; i++)
+					ImGui::TextDisabled("%+.4f %+.4fi", m_NewtonPolynomial.roots[i].x, m_NewtonPolynomial.roots[i].y);
+			}
+
+			if (p_SelectedFractal == FRACTAL_BUDDHABROT && m_BuddhabrotRenderer) {
+				ImGui::Checkbox("Nebulabrot", &m_isNebulabrotOn);
+				const Buddhabrot& sampler = m_BuddhabrotRenderer->GetSampler();
+				const Buddhabrot::Settings& settings = sampler.GetSettings();
+				ImGui::Text("%.1fM orbits sampled, %.0f%% of proposals accepted", sampler.GetSampleCount() / 1.0e6, 100.0 * sampler.GetAcceptance());
+				ImGui::Text("Iteration caps: %d, %d, %d", settings.iterations[0], settings.iterations[1], settings.iterations[2]);
+			}
+
+			if (m_isComputeAvailable) {
+				ImGui::Checkbox("Compute Backend", &m_UseComputeBackend);
+				if (m_UseComputeBackend) {
+					ImGui::SliderInt("Persistent Groups", &m_PersistentGroups, 1, 1024);
+					ImGui::Checkbox("Chunked Iterations", &m_UseChunkedIterations);
+					if (m_UseChunkedIterations)
+						ImGui::SliderInt("Chunk Size", &m_ChunkSize, 8, 1024);
+
+					const IterationHistogram& histogram = m_ComputeRenderer->GetHistogram();
+					if (p_SelectedFractal < FRACTAL_MANDELBULB && !m_RenderThread && histogram.HasResult()) {
+						ImGui::PlotHistogram("Escape Iterations", histogram.GetFractions(), IterationHistogram::c_NumBins, 0, nullptr, 0.0f, FLT_MAX, { 0, 60 });
+						ImGui::Text("%.1f%% of pixels hit the %d iteration cap, %.0fM iterations a frame",
+							100.0f * histogram.GetCapFraction(), histogram.GetIterations(), histogram.GetTotalIterations() / 1.0e6);
+					}
+				}
+			}
+			else {
+				ImGui::TextDisabled("Compute backend needs OpenGL 4.3");
+			}
+
 			m_isColor1SelectorUsed = ImGui::SliderFloat3("Color 1", m_Color1, 0.0f, 1.0f);
 			ImGui::SameLine();
 			m_isRandomiseColor1ButtonPressed = ImGui::Button("Randomise##Color 1");
@@ -188,6 +388,46 @@ void Application::Run()
 			ImGui::SameLine();
 			m_isSavePresetButtonPressed = ImGui::Button("Save Preset");
 
+			if (ImGui::Combo("Quality", &m_SelectedQuality, m_QualityOptions, c_NumQualityOptions)) {
+				m_QualityController->SetAuto(m_SelectedQuality == 0);
+				if (m_SelectedQuality > 0)
+					m_QualityController->SetForcedTier(static_cast<QualityTier>(m_SelectedQuality - 1));
+			}
+			if (m_QualityController->IsAuto()) {
+				float target = m_QualityController->GetTargetMilliseconds();
+				if (ImGui::SliderFloat("Target Frame Time (ms)", &target, 4.0f, 100.0f))
+					m_QualityController->SetTargetMilliseconds(target);
+			}
+			const QualityBudget& budget = m_QualityController->GetBudget();
+			ImGui::Text("%s tier: %.0f%% resolution, %.0f%% iterations, %.1f ms GPU",
+				QualityController::c_TierNames[static_cast<int>(m_QualityController->GetTier())],
+				100.0f * budget.resolutionScale, 100.0f * budget.iterationScale, m_QualityController->GetGpuMilliseconds());
+
+			if (p_SelectedFractal == FRACTAL_MANDELBULB) {
+				ImGui::Checkbox("Animate Power", &m_isBulbPowerAnimated);
+				if (!m_isBulbPowerAnimated)
+					ImGui::SliderFloat("Power", &m_BulbPower, 1.0f, 16.0f);
+				ImGui::Checkbox("Show Step Counts", &m_isBulbStepViewOn);
+				ImGui::Checkbox("Orbit Trap Colouring", &m_isBulbTrapColoringOn);
+				if (m_ConePrepass->IsValid()) {
+					ImGui::Checkbox("Cone Pre-pass", &m_isConePrepassOn);
+					if (m_isConePrepassOn)
+						ImGui::SliderInt("Cone Block Size", &m_ConeBlockSize, 2, 32);
+				}
+				ImGui::Checkbox("Accumulate Samples", &m_isAccumulationOn);
+				if (m_isAccumulationOn)
+					ImGui::Text("Samples: %d / %d", m_AccumulationBuffer->GetSampleIndex(), AccumulationBuffer::c_MaxSamples);
+				ImGui::Checkbox("Baked Distance Volume", &m_isDistanceVolumeOn);
+				if (m_isDistanceVolumeOn) {
+					if (m_isBulbPowerAnimated)
+						ImGui::TextDisabled("Volume is only baked while the power is still");
+					else if (m_DistanceVolume->IsBaking())
+						ImGui::Text("Baking %d^3 volume...", m_DistanceVolume->GetSize());
+					else
+						ImGui::Text("Last bake: %.0f ms", m_DistanceVolume->GetLastBakeMilliseconds());
+				}
+			}
+
 			if (m_isJuliaMode) {
 				ImGui::Checkbox("Julia Orbit", &m_isJuliaOrbitOn);
 				if (m_isJuliaOrbitOn) {
@@ -206,20 +446,53 @@ void Application::Run()
 				"H - Toggle GUI visibility (useful for screenshots and videos)\n"
 				"P - Take a screenshot"
 			);
+			ImGui::Text("Redundant GL calls skipped: %u", GLState::GetSkippedLastFrame());
+			ImGui::Text("Allocations last frame: %llu", static_cast<unsigned long long>(m_FrameAllocations));
+			if (ImGui::Checkbox("Render Thread", &m_isRenderThreadOn))
+				SetRenderThread(m_isRenderThreadOn);
+			if (m_isRenderThreadOn)
+				ImGui::TextDisabled("Accumulation, the baked volume and the histogram are off");
+			ImGui::Checkbox("Performance Overlay", &m_isProfilerOverlayOn);
 			ImGui::End();
+
+			if (m_isProfilerOverlayOn)
+				m_Profiler->DrawOverlay(&m_isProfilerOverlayOn);
 		}
 
 		ImGui::Render();
+		m_Profiler->Begin(m_ImGuiGpuSection);
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		m_Profiler->End(m_ImGuiGpuSection);
+		m_Profiler->End(m_ImGuiSection);
 	
+		m_Profiler->Begin(m_CheckUISection);
 		CheckUI();
-		UpdateShaderMousePosition();
+		m_Profiler->End(m_CheckUISection);
+		{
+			TRACE_SCOPE("Update Mouse Position");
+			UpdateShaderMousePosition();
+		}
 
 		// glfw: swap buffers and poll IO events (key presses, mouse interactions etc.)
 		// -------------------------------------------------------------------------------
+		m_Profiler->Begin(m_SwapSection);
 		glfwSwapBuffers(p_Window);
-		glfwPollEvents();
+		m_Profiler->End(m_SwapSection);
+		{
+			// key and scroll callbacks, screenshots included, run in here
+			TRACE_SCOPE("Poll Events");
+			glfwPollEvents();
+		}
+
+		m_Profiler->End(m_FrameSection);
+
+		// once warmed up a frame should not allocate; one-off work that has to is marked Exempt
+		m_FrameAllocations = AllocationCounter::GetThreadAllocations() - frameStartAllocations;
+		assert((frames < c_AllocationWarmupFrames || m_FrameAllocations == 0) && "the frame loop allocated after warming up");
 	}
+	// its context has to go before GLFW does, and the sampler's texture with it
+	m_RenderThread.reset();
+	m_BuddhabrotRenderer.reset();
 	glfwTerminate();
 
 }
@@ -247,23 +520,26 @@ void Application::key_callback(GLFWwindow* window, int key, int scancode, int ac
 			break;
 		}
 		case GLFW_KEY_P: {
+			TRACE_SCOPE("Screenshot");
 			int width, height;
 			glfwGetWindowSize(p_Window, &width, &height);
 
-			uint8_t* pixels = new uint8_t[3 * width * height];
+			// a screenshot is one-off work; the pixels are kept for the next one all the same
+			AllocationCounter::Exempt exempt;
+			ptr->m_ScreenshotPixels.resize(3 * width * height);
 
-			glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+			{
+				TRACE_SCOPE("glReadPixels");
+				glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, ptr->m_ScreenshotPixels.data());
+			}
 			
 			// create name
-			std::stringstream stream; 
-			stream << ptr->m_FractalOptions[ptr->p_SelectedFractal];
-			if (ptr->m_isJuliaMode)
-				stream << " Julia Set";
-			stream << " at " << ptr->m_Location.x << " + " << ptr->m_Location.y << "i.png";
-			std::string result = stream.str();
+			char name[256];
+			snprintf(name, sizeof(name), "%s%s at %g + %gi.png", ptr->m_FractalOptions[ptr->p_SelectedFractal],
+				ptr->m_isJuliaMode ? " Julia Set" : "", ptr->m_Location.x, ptr->m_Location.y);
 
 			// save png
-			ptr->save_png_libpng(result.c_str(), pixels, width, height);
+			PngWriter::Save(name, ptr->m_ScreenshotPixels.data(), width, height);
 
 			break;
 		}
@@ -287,7 +563,7 @@ void Application::framebuffer_size_callback(GLFWwindow * window, int width, int
 {
 	Application* ptr = (Application*)glfwGetWindowUserPointer(window);
 
-	glViewport(0, 0, width, height);
+	GLState::Viewport(0, 0, width, height);
 	glUniform2i(ptr->m_ResolutionLoc, width, height);
 }
 
@@ -305,20 +581,214 @@ void Application::UpdateShaderMousePosition() {
 			if (m_isJuliaOrbitOn) {			
 				float newXPos = m_MouseXPos + sin(m_JuliaOrbitSpeed * static_cast<float>(glfwGetTime())) * m_JuliaOrbitRadius;
 				float newYPos = m_MouseYPos + cos(m_JuliaOrbitSpeed * static_cast<float>(glfwGetTime())) * m_JuliaOrbitRadius;
+				m_JuliaConstant = { newXPos, newYPos };
 				glUniform2f(m_MousePosLoc, newXPos, newYPos);
 			}
 			else {
+				m_JuliaConstant = { m_MouseXPos, m_MouseYPos };
 				glUniform2f(m_MousePosLoc, m_MouseXPos, m_MouseYPos);
 			}
 		}
 		else if (m_isJuliaPaused && m_isJuliaOrbitOn) {
 			float newXPos = m_MouseXPos + sin(m_JuliaOrbitSpeed * static_cast<float>(glfwGetTime())) * m_JuliaOrbitRadius;
 			float newYPos = m_MouseYPos + cos(m_JuliaOrbitSpeed * static_cast<float>(glfwGetTime())) * m_JuliaOrbitRadius;
+			m_JuliaConstant = { newXPos, newYPos };
 			glUniform2f(m_MousePosLoc, newXPos, newYPos);
 		}
 	}
 }
 
+bool Application::RenderMandelbulb(const FractalParams& frameParams, const Framebuffer* target, int windowWidth, int windowHeight, const VertexArray& quad)
+{
+	// the bulb keeps its own iteration count until the slider is used, so ask the shader
+	FractalParams params = frameParams;
+	glGetUniformiv(m_ShaderID, m_IterationsLoc, &params.iterations);
+
+	// anything that changes the image starts the average over
+	if (m_isAccumulationOn) {
+		float view[c_AccumulatedViewSize] = { m_Location.x, m_Location.y, m_BulbPower, static_cast<float>(params.iterations), static_cast<float>(m_isBulbStepViewOn),
+			static_cast<float>(m_QualityController->GetTier()), static_cast<float>(m_isBulbTrapColoringOn) };
+		// the palette only shows with trap colouring, and is left at zero without it
+		if (m_isBulbTrapColoringOn) {
+			const float* colors[] = { m_Color1, m_Color2, m_Color3, m_Color4 };
+			for (int i = 0; i < 4; i++)
+				std::copy(colors[i], colors[i] + 3, view + 7 + 3 * i);
+		}
+		if (!std::equal(view, view + c_AccumulatedViewSize, m_AccumulatedView)) {
+			std::copy(view, view + c_AccumulatedViewSize, m_AccumulatedView);
+			m_AccumulationBuffer->Reset();
+		}
+		m_AccumulationBuffer->Resize(params.width, params.height);
+
+		// a converged view only needs showing again
+		if (m_AccumulationBuffer->IsConverged()) {
+			m_AccumulationBuffer->Present(windowWidth, windowHeight);
+			return true;
+		}
+	}
+
+	if (m_isConePrepassOn) {
+		m_ConePrepass->SetBlockSize(m_ConeBlockSize);
+		m_ConePrepass->Render(params, m_BulbPower, quad);
+		m_ConePrepass->GetDepth().Bind(0);
+
+		// the pre-pass leaves the window bound
+		if (target)
+			target->Bind();
+	}
+
+	// a bake takes far longer than a frame, so there is no point while the power animates
+	bool useVolume = m_isDistanceVolumeOn && !m_isBulbPowerAnimated && m_DistanceVolume->Request(m_BulbPower, params.iterations);
+	if (useVolume)
+		m_DistanceVolume->Bind(DistanceVolume::c_TextureUnit);
+
+	p_SelectedShader->Bind();
+	glUniform1i(m_UseVolumeLoc, useVolume);
+	glUniform1i(m_AccumulateLoc, m_isAccumulationOn);
+
+	if (m_isAccumulationOn) {
+		glUniform1i(m_SampleIndexLoc, m_AccumulationBuffer->GetSampleIndex());
+		m_AccumulationBuffer->BeginSample();
+	}
+
+	quad.Bind();
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+	if (m_isAccumulationOn) {
+		m_AccumulationBuffer->EndSample();
+		m_AccumulationBuffer->Present(windowWidth, windowHeight);
+		return true;
+	}
+	return false;
+}
+
+bool Application::HasViewChanged()
+{
+	int width, height;
+	glfwGetFramebufferSize(p_Window, &width, &height);
+
+	float view[c_QualityViewSize] = {
+		m_Location.x, m_Location.y, m_Zoom, m_JuliaConstant.x, m_JuliaConstant.y, static_cast<float>(m_isJuliaMode),
+		static_cast<float>(p_SelectedFractal), m_BulbPower, static_cast<float>(m_Iterations), static_cast<float>(width * 65536 + height), m_MultibrotPower,
+		static_cast<float>(m_NewtonRevision)
+	};
+	if (std::equal(view, view + c_QualityViewSize, m_QualityView))
+		return false;
+
+	std::copy(view, view + c_QualityViewSize, m_QualityView);
+	return true;
+}
+
+void Application::UpdateAutoIterations(bool isViewChanging)
+{
+	// the compute kernels count every pixel for free; without them a coarse
+	// CPU sample stands in, spread over frames as it costs real time at high
+	// caps, and only while the view holds still
+	EscapeStats stats;
+	if (m_UseComputeBackend && m_isComputeAvailable && !m_RenderThread && p_SelectedFractal < FRACTAL_MANDELBULB) {
+		stats = IterationController::FromHistogram(m_ComputeRenderer->GetHistogram());
+	}
+	else if (isViewChanging) {
+		m_FramesSinceSample = 0;
+		m_IterationController->RestartSample();
+	}
+	else if (++m_FramesSinceSample >= c_CpuSampleInterval && m_IterationController->SampleCpu(GetFractalParams(), stats)) {
+		m_FramesSinceSample = 0;
+	}
+
+	// the controller's own changes keep the quality tier, only the slider's drop to Interactive
+	int iterations = m_IterationController->Update(m_Iterations, m_Zoom, stats);
+	if (iterations != m_Iterations) {
+		m_Iterations = iterations;
+		m_QualityView[c_QualityViewIterations] = static_cast<float>(iterations);
+	}
+}
+
+void Application::ApplyQualityBudget(FractalParams& params)
+{
+	const QualityBudget& budget = m_QualityController->GetBudget();
+
+	params.width = std::max(1, static_cast<int>(params.width * budget.resolutionScale + 0.5f));
+	params.height = std::max(1, static_cast<int>(params.height * budget.resolutionScale + 0.5f));
+
+	// the bulb's own iteration count is left alone, its cost is in the steps
+	p_SelectedShader->Bind();
+	if (p_SelectedShader == &m_MandelbulbShader) {
+		glUniform1i(m_MaxStepsLoc, budget.maxSteps);
+		glUniform1i(m_MaxShadowStepsLoc, budget.maxShadowSteps);
+		glUniform1f(m_SurfaceDistLoc, budget.surfaceDist);
+	}
+	else {
+		params.iterations = std::max(1, static_cast<int>(params.iterations * budget.iterationScale + 0.5f));
+		glUniform1i(m_IterationsLoc, params.iterations);
+	}
+	glUniform2i(m_ResolutionLoc, params.width, params.height);
+}
+
+RenderSnapshot Application::GetRenderSnapshot(const FractalParams& params) const
+{
+	RenderSnapshot snapshot;
+	snapshot.params = params;
+	snapshot.tier = static_cast<int>(m_QualityController->GetTier());
+
+	// the bulb keeps its own iteration count until the slider is used, so ask the shader
+	if (params.fractal == FRACTAL_MANDELBULB)
+		glGetUniformiv(m_ShaderID, m_IterationsLoc, &snapshot.params.iterations);
+
+	const QualityBudget& budget = m_QualityController->GetBudget();
+	snapshot.power = m_BulbPower;
+	snapshot.maxSteps = budget.maxSteps;
+	snapshot.maxShadowSteps = budget.maxShadowSteps;
+	snapshot.surfaceDist = budget.surfaceDist;
+	snapshot.showSteps = m_isBulbStepViewOn;
+	snapshot.trapColoring = m_isBulbTrapColoringOn;
+	snapshot.coneBlockSize = m_isConePrepassOn ? m_ConeBlockSize : 0;
+
+	// there are no kernels for the Multibrot and Multicorn
+	snapshot.useCompute = m_UseComputeBackend && m_isComputeAvailable && params.fractal < FRACTAL_MANDELBULB;
+	snapshot.persistentGroups = m_PersistentGroups;
+	snapshot.chunkSize = m_UseChunkedIterations ? m_ChunkSize : 0;
+	return snapshot;
+}
+
+void Application::SetRenderThread(bool isOn)
+{
+	// starting and stopping the thread is one-off work
+	AllocationCounter::Exempt exempt;
+	if (!isOn) {
+		m_RenderThread.reset();
+		return;
+	}
+
+	m_RenderThread = std::make_unique<RenderThread>();
+	if (!m_RenderThread->IsValid()) {
+		std::cout << "Failed to create a shared context for the render thread" << std::endl;
+		m_RenderThread.reset();
+		m_isRenderThreadOn = false;
+	}
+}
+
+FractalParams Application::GetFractalParams() const
+{
+	FractalParams params;
+	params.fractal = p_SelectedFractal;
+	glfwGetFramebufferSize(p_Window, &params.width, &params.height);
+	params.location = m_Location;
+	params.juliaConstant = m_JuliaConstant;
+	params.juliaMode = m_isJuliaMode;
+	params.zoom = m_Zoom;
+	params.iterations = m_Iterations;
+	params.power = m_MultibrotPower;
+	params.newton = m_NewtonPolynomial;
+	for (int i = 0; i < 3; i++) {
+		params.colors[0][i] = m_Color1[i];
+		params.colors[1][i] = m_Color2[i];
+		params.colors[2][i] = m_Color3[i];
+		params.colors[3][i] = m_Color4[i];
+	}
+	return params;
+}
+
 std::unique_ptr<Application>& Application::GetInstance() {
     if (Application::s_Instance == nullptr) {
         Application::s_Instance = std::unique_ptr<Application>(new Application);
@@ -354,6 +824,29 @@ void Application::UpdateShaderUniformLocations()
 	m_Color2Loc = glGetUniformLocation(m_ShaderID, "color_2");
 	m_Color3Loc = glGetUniformLocation(m_ShaderID, "color_3");
 	m_Color4Loc = glGetUniformLocation(m_ShaderID, "color_4");
+	m_PowerLoc = glGetUniformLocation(m_ShaderID, "power");
+	m_ExponentLoc = glGetUniformLocation(m_ShaderID, "exponent");
+	m_ShowStepsLoc = glGetUniformLocation(m_ShaderID, "showSteps");
+	m_TrapColoringLoc = glGetUniformLocation(m_ShaderID, "trapColoring");
+	m_ConeBlockLoc = glGetUniformLocation(m_ShaderID, "coneBlock");
+	m_UseVolumeLoc = glGetUniformLocation(m_ShaderID, "useVolume");
+	m_AccumulateLoc = glGetUniformLocation(m_ShaderID, "accumulate");
+	m_SampleIndexLoc = glGetUniformLocation(m_ShaderID, "sampleIndex");
+	m_MaxStepsLoc = glGetUniformLocation(m_ShaderID, "maxSteps");
+	m_MaxShadowStepsLoc = glGetUniformLocation(m_ShaderID, "maxShadowSteps");
+	m_SurfaceDistLoc = glGetUniformLocation(m_ShaderID, "surfaceDist");
+}
+
+void Application::UpdateNewtonPolynomial()
+{
+	Newton::FindRoots(m_NewtonPolynomial);
+	m_NewtonRevision++;
+
+	m_NewtonShader.Bind();
+	glUniform1i(m_NewtonShader.GetLocation("degree"), m_NewtonPolynomial.degree);
+	glUniform2fv(m_NewtonShader.GetLocation("coefficients"), NewtonPolynomial::c_MaxDegree + 1, &m_NewtonPolynomial.coefficients[0].x);
+	glUniform1i(m_NewtonShader.GetLocation("rootCount"), m_NewtonPolynomial.rootCount);
+	glUniform2fv(m_NewtonShader.GetLocation("roots"), NewtonPolynomial::c_MaxDegree, &m_NewtonPolynomial.roots[0].x);
 }
 
 void Application::RandomiseColor2()
@@ -498,8 +991,16 @@ void Application::CheckUI()
 		RandomiseColor4();
 	}
 
+	if (m_isNewtonPolynomialUsed && p_SelectedFractal == FRACTAL_NEWTON)
+		UpdateNewtonPolynomial();
+
+	// a new power may need another variant, which is switched to as a new fractal would be
+	bool isMultibrot = p_SelectedFractal == FRACTAL_MULTIBROT || p_SelectedFractal == FRACTAL_MULTICORN;
+	bool isShaderChanged = m_isFractalSelectorUsed
+		|| (m_isMultibrotPowerUsed && isMultibrot && &m_MultibrotShaders->Get(p_SelectedFractal, m_MultibrotPower) != p_SelectedShader);
+
 	// change selected fractal
-	if (m_isFractalSelectorUsed) {
+	if (isShaderChanged) {
 		switch (p_SelectedFractal) {
 		case 0: {
 			p_SelectedShader = &m_MandelbrotShader;
@@ -517,6 +1018,28 @@ void Application::CheckUI()
 			p_SelectedShader = &m_MandelbulbShader;
 			break;
 		}
+		case 4: {
+			// the Mandelbrot shader only takes the uniforms, the image comes from the CPU
+			p_SelectedShader = &m_MandelbrotShader;
+			if (!m_BuddhabrotRenderer) {
+				AllocationCounter::Exempt exempt;
+				m_BuddhabrotRenderer = std::make_unique<BuddhabrotRenderer>();
+			}
+			break;
+		}
+		case 5:
+		case 6: {
+			if (!m_MultibrotShaders) {
+				AllocationCounter::Exempt exempt;
+				m_MultibrotShaders = std::make_unique<MultibrotShaders>();
+			}
+			p_SelectedShader = &m_MultibrotShaders->Get(p_SelectedFractal, m_MultibrotPower);
+			break;
+		}
+		case 7: {
+			p_SelectedShader = &m_NewtonShader;
+			break;
+		}
 		}
 		p_SelectedShader->Bind();
 
@@ -530,54 +1053,10 @@ void Application::CheckUI()
 		glUniform1f(m_ZoomLoc, m_Zoom);
 		glUniform1i(m_JuliaModeLoc, m_isJuliaMode);
 		glUniform1i(m_IterationsLoc, m_Iterations);
+		glUniform1f(m_ExponentLoc, m_MultibrotPower);
 		glUniform3f(m_Color1Loc, m_Color1[0], m_Color1[1], m_Color1[2]);
 		glUniform3f(m_Color2Loc, m_Color2[0], m_Color2[1], m_Color2[2]);
 		glUniform3f(m_Color3Loc, m_Color3[0], m_Color3[1], m_Color3[2]);
 		glUniform3f(m_Color4Loc, m_Color4[0], m_Color4[1], m_Color4[2]);
 	}
 }
-
-bool Application::save_png_libpng(const char* filename, uint8_t* pixels, int w, int h)
-{
-	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-	if (!png)
-		return false;
-
-	png_infop info = png_create_info_struct(png);
-	if (!info) {
-		png_destroy_write_struct(&png, &info);
-		return false;
-	}
-
-	FILE* fp = fopen(filename, "wb");
-	if (!fp) {
-		png_destroy_write_struct(&png, &info);
-		return false;
-	}
-
-	png_init_io(png, fp);
-	png_set_IHDR(png, info, w, h, 8 /* depth */, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
-		PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-	png_colorp palette = (png_colorp)png_malloc(png, PNG_MAX_PALETTE_LENGTH * sizeof(png_color));
-	if (!palette) {
-		fclose(fp);
-		png_destroy_write_struct(&png, &info);
-		return false;
-	}
-	png_set_PLTE(png, info, palette, PNG_MAX_PALETTE_LENGTH);
-	png_write_info(png, info);
-	png_set_packing(png);
-
-	png_bytepp rows = (png_bytepp)png_malloc(png, h * sizeof(png_bytep));
-	for (int i = 0; i < h; ++i)
-		rows[i] = (png_bytep)(pixels + (h - i) * w * 3);
-
-	png_write_image(png, rows);
-	png_write_end(png, info);
-	png_free(png, palette);
-	png_destroy_write_struct(&png, &info);
-
-	fclose(fp);
-	delete[] rows;
-	return true;
-}
\ No newline at end of file
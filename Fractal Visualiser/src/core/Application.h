@@ -1,14 +1,24 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <shader/Shader.h>
-
-struct Vec2 {
-	float x;
-	float y;
-};
+#include <core/FractalParams.h>
+#include <core/Profiler.h>
+#include <renderer/ComputeRenderer.h>
+#include <renderer/ConePrepass.h>
+#include <renderer/DistanceVolume.h>
+#include <renderer/AccumulationBuffer.h>
+#include <renderer/BuddhabrotRenderer.h>
+#include <renderer/Framebuffer.h>
+#include <renderer/IterationController.h>
+#include <renderer/MultibrotShaders.h>
+#include <renderer/QualityController.h>
+#include <renderer/RenderThread.h>
+#include <vertex/VertexArray.h>
 
 class Application
 {
@@ -25,6 +35,7 @@ private:
 	Shader m_BurningshipShader;
 	Shader m_TricornShader;
 	Shader m_MandelbulbShader;
+	Shader m_NewtonShader;
 	Shader* p_SelectedShader = nullptr;
 
 	unsigned int m_ShaderID = 0;
@@ -33,8 +44,8 @@ private:
 
 	// fractal selection
 	int p_SelectedFractal = 0;
-	static constexpr unsigned int c_NumFractals = 4;
-	const char* m_FractalOptions[c_NumFractals] = {"Mandelbrot", "Burning Ship", "Tricorn", "Mandelbulb"};
+	static constexpr unsigned int c_NumFractals = 8;
+	const char* m_FractalOptions[c_NumFractals] = {"Mandelbrot", "Burning Ship", "Tricorn", "Mandelbulb", "Buddhabrot", "Multibrot", "Multicorn", "Newton"};
 
 	// fractal properties - uniforms
 	Vec2 m_Location  = {0.0f, 0.0f};
@@ -49,6 +60,15 @@ private:
 
 	// other properties - non uniform
 	bool m_isJuliaPaused = false;
+	Vec2 m_JuliaConstant = { 0.0f, 0.0f };
+
+	// compute backend for the 2D fractals, only created on a GL 4.3 context
+	std::unique_ptr<ComputeRenderer> m_ComputeRenderer;
+	bool m_isComputeAvailable = false;
+	bool m_UseComputeBackend = false;
+	int m_PersistentGroups = 128;
+	bool m_UseChunkedIterations = false;
+	int m_ChunkSize = 64;
 
 	float m_MinR = 0.0f;
 	float m_MaxR = 0.0f;
@@ -63,6 +83,8 @@ private:
 	bool m_isIterationsSliderUsed = false;
 	bool m_isJuliaModeCheckboxUsed = false;
 	bool m_isFractalSelectorUsed = false;
+	bool m_isMultibrotPowerUsed = false;
+	bool m_isNewtonPolynomialUsed = false;
 
 	bool m_isColor1SelectorUsed = false;
 	bool m_isColor2SelectorUsed = false;
@@ -89,6 +111,87 @@ private:
 		{{0.449f, 0.0f, 0.5f}, {0.5f, 0.173f, 0.5f}, {1.0f, 1.0f, 1.0f}, {0.673f, 0.391f, 0.678f}}
 	};
 
+	// mandelbulb power, whole numbers take the trig-free path in the shader
+	float m_BulbPower = 8.0f;
+	bool m_isBulbPowerAnimated = true;
+
+	// Multibrot and Multicorn power; whole powers get a shader variant without trig
+	std::unique_ptr<MultibrotShaders> m_MultibrotShaders;
+	float m_MultibrotPower = 3.0f;
+	bool m_isWholePowerOn = true;
+
+	// the Newton fractal's polynomial, roots found again whenever it is edited
+	NewtonPolynomial m_NewtonPolynomial;
+	// moves with every edit, so the quality controller sees one as a view change
+	int m_NewtonRevision = 0;
+	// colours the mandelbulb by ray march steps per pixel instead of lighting
+	bool m_isBulbStepViewOn = false;
+	// tints the mandelbulb with the colour palette from its orbit traps
+	bool m_isBulbTrapColoringOn = false;
+
+	// low resolution cone march that gives the mandelbulb rays a head start
+	std::unique_ptr<ConePrepass> m_ConePrepass;
+	bool m_isConePrepassOn = true;
+	int m_ConeBlockSize = 8;
+
+	// baked distance field for the mandelbulb, rebaked in the background when the power settles
+	std::unique_ptr<DistanceVolume> m_DistanceVolume;
+	bool m_isDistanceVolumeOn = true;
+
+	// averages jittered mandelbulb frames while the view holds still
+	std::unique_ptr<AccumulationBuffer> m_AccumulationBuffer;
+	bool m_isAccumulationOn = true;
+	// seven view values, then the four palette colours
+	static constexpr int c_AccumulatedViewSize = 7 + 12;
+	float m_AccumulatedView[c_AccumulatedViewSize] = {};
+
+	// step, iteration and resolution budgets, tuned to a frame time while the view moves
+	std::unique_ptr<QualityController> m_QualityController;
+	int m_SelectedQuality = 0;
+	static constexpr unsigned int c_NumQualityOptions = QualityController::c_NumTiers + 1;
+	const char* m_QualityOptions[c_NumQualityOptions] = { "Auto", "Interactive", "Preview", "Final" };
+	static constexpr int c_QualityViewSize = 12;
+	// where the iteration cap sits in the view
+	static constexpr int c_QualityViewIterations = 8;
+	float m_QualityView[c_QualityViewSize] = {};
+	// the fractal is drawn here and scaled up when the budget is below full size
+	std::unique_ptr<Framebuffer> m_ScaledTarget;
+
+	// picks the 2D iteration cap from how pixels escape and the zoom depth
+	std::unique_ptr<IterationController> m_IterationController;
+	bool m_isAutoIterationsOn = false;
+	// the CPU sample used without the compute histogram starts this many frames after the last one finished
+	static constexpr int c_CpuSampleInterval = 8;
+	int m_FramesSinceSample = 0;
+
+	// draws the fractal off the main thread, so slow frames leave the UI responsive
+	std::unique_ptr<RenderThread> m_RenderThread;
+	bool m_isRenderThreadOn = false;
+
+	// made the first time the Buddhabrot is picked, and paused while it is not shown
+	std::unique_ptr<BuddhabrotRenderer> m_BuddhabrotRenderer;
+	bool m_isNebulabrotOn = false;
+
+	// operator new calls on this thread in the last frame, which stay at zero
+	// once the first frames have sized every buffer
+	uint64_t m_FrameAllocations = 0;
+	static constexpr int c_AllocationWarmupFrames = 120;
+	// screenshots read back into this, so repeated ones reuse it
+	std::vector<uint8_t> m_ScreenshotPixels;
+
+	// frame timings, shown in the performance overlay
+	std::unique_ptr<Profiler> m_Profiler;
+	bool m_isProfilerOverlayOn = false;
+	int m_FrameSection = 0;
+	int m_InputSection = 0;
+	int m_CheckUISection = 0;
+	int m_SubmitSection = 0;
+	int m_ImGuiSection = 0;
+	int m_SwapSection = 0;
+	int m_FractalGpuSection = 0;
+	int m_UpscaleGpuSection = 0;
+	int m_ImGuiGpuSection = 0;
+
 	// julia set orbitals
 	bool m_isJuliaOrbitOn = false;
 	float m_JuliaOrbitSpeed = 1.0f;
@@ -112,6 +215,17 @@ private:
 	unsigned int m_Color2Loc = 0;
 	unsigned int m_Color3Loc = 0;
 	unsigned int m_Color4Loc = 0;
+	unsigned int m_PowerLoc = 0;
+	unsigned int m_ExponentLoc = 0;
+	unsigned int m_ShowStepsLoc = 0;
+	unsigned int m_TrapColoringLoc = 0;
+	unsigned int m_ConeBlockLoc = 0;
+	unsigned int m_UseVolumeLoc = 0;
+	unsigned int m_AccumulateLoc = 0;
+	unsigned int m_SampleIndexLoc = 0;
+	unsigned int m_MaxStepsLoc = 0;
+	unsigned int m_MaxShadowStepsLoc = 0;
+	unsigned int m_SurfaceDistLoc = 0;
 
 	// functions
 	template<typename T>
@@ -120,9 +234,17 @@ private:
 	//utility functiosn for app
 	void UpdateShaderMousePosition();
 	void UpdateShaderUniformLocations();
-
-	// image saving
-	bool save_png_libpng(const char* filename, uint8_t* pixels, int w, int h);
+	// finds the roots of m_NewtonPolynomial and hands both to the Newton shader
+	void UpdateNewtonPolynomial();
+	FractalParams GetFractalParams() const;
+	RenderSnapshot GetRenderSnapshot(const FractalParams& params) const;
+	void SetRenderThread(bool isOn);
+	bool HasViewChanged();
+	void UpdateAutoIterations(bool isViewChanging);
+	void ApplyQualityBudget(FractalParams& params);
+	// draws into target, or the window when it is null. True if the image was
+	// already put in the window by the accumulation buffer
+	bool RenderMandelbulb(const FractalParams& params, const Framebuffer* target, int windowWidth, int windowHeight, const VertexArray& quad);
 
 	void RandomiseColor1();
 	void RandomiseColor2();
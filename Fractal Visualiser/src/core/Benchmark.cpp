@@ -0,0 +1,408 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <cpu/EscapeTime.h>
+#include <renderer/AccumulationBuffer.h>
+#include <renderer/DistanceVolume.h>
+#include <vertex/VertexBufferLayout.h>
+
+namespace {
+	const float c_QuadVertices[] = { 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f };
+	const unsigned int c_QuadIndices[] = { 0, 1, 3, 1, 2, 3 };
+
+	// the Multibrot and Multicorn come from MultibrotShaders
+	const char* c_ShaderPaths[Benchmark::c_NumFractals] = {
+		"res/shaders/mandelbrot.shader", "res/shaders/burningship.shader", "res/shaders/tricorn.shader", "res/shaders/mandelbulb.shader",
+		nullptr, nullptr, nullptr
+	};
+	// scene file names, in FractalType order; null for fractals scenes can not use
+	const char* c_FractalNames[Benchmark::c_NumFractals] = { "mandelbrot", "burningship", "tricorn", "mandelbulb", nullptr, "multibrot", "multicorn" };
+
+	// iteration count for scenes that leave it out, the bulb's default is far lower
+	const int c_DefaultIterations[Benchmark::c_NumFractals] = { 200, 200, 200, 20, 0, 200, 200 };
+
+	// the iteration estimate walks every c_CountStride'th pixel each way
+	const int c_CountStride = 4;
+
+	std::string Trim(const std::string& text)
+	{
+		size_t first = text.find_first_not_of(" \t\r");
+		if (first == std::string::npos)
+			return "";
+		size_t last = text.find_last_not_of(" \t\r");
+		return text.substr(first, last - first + 1);
+	}
+
+	std::string EscapeJSON(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+				escaped += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				escaped += ' ';
+			}
+			else {
+				escaped += c;
+			}
+		}
+		return escaped;
+	}
+
+	std::string GetGLString(unsigned int name)
+	{
+		const GLubyte* value = glGetString(name);
+		return value ? reinterpret_cast<const char*>(value) : "";
+	}
+
+	void WriteStats(std::ostream& out, const char* name, const Benchmark::Stats& stats)
+	{
+		out << "\"" << name << "\": { \"min\": " << stats.min << ", \"mean\": " << stats.mean
+			<< ", \"p50\": " << stats.p50 << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99 << " }";
+	}
+}
+
+bool Benchmark::LoadScenes(const std::string& path, std::vector<BenchmarkScene>& scenes, std::string& error)
+{
+	std::ifstream stream(path);
+	if (!stream) {
+		error = "could not open " + path;
+		return false;
+	}
+
+	// iterations default per fractal, so remember which scenes set them
+	std::vector<bool> hasIterations;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(stream, line)) {
+		lineNumber++;
+		line = Trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		if (line.front() == '[') {
+			if (line.back() != ']') {
+				error = path + ":" + std::to_string(lineNumber) + ": scene header is missing its ]";
+				return false;
+			}
+			scenes.emplace_back();
+			scenes.back().name = Trim(line.substr(1, line.size() - 2));
+			hasIterations.push_back(false);
+			continue;
+		}
+
+		size_t equals = line.find('=');
+		if (equals == std::string::npos || scenes.empty()) {
+			error = path + ":" + std::to_string(lineNumber) + ": expected key = value inside a [scene]";
+			return false;
+		}
+
+		std::string key = Trim(line.substr(0, equals));
+		std::istringstream value(line.substr(equals + 1));
+		BenchmarkScene& scene = scenes.back();
+		FractalParams& params = scene.params;
+
+		bool isValid = true;
+		if (key == "fractal") {
+			std::string name;
+			value >> name;
+			isValid = false;
+			for (int i = 0; i < c_NumFractals; i++) {
+				if (c_FractalNames[i] && name == c_FractalNames[i]) {
+					params.fractal = i;
+					isValid = true;
+				}
+			}
+		}
+		else if (key == "location") {
+			isValid = static_cast<bool>(value >> params.location.x >> params.location.y);
+		}
+		else if (key == "zoom") {
+			isValid = static_cast<bool>(value >> params.zoom);
+		}
+		else if (key == "iterations") {
+			isValid = static_cast<bool>(value >> params.iterations) && params.iterations > 0;
+			hasIterations.back() = true;
+		}
+		else if (key == "julia") {
+			isValid = static_cast<bool>(value >> params.juliaConstant.x >> params.juliaConstant.y);
+			params.juliaMode = true;
+		}
+		else if (key == "resolution") {
+			isValid = static_cast<bool>(value >> params.width >> params.height) && params.width > 0 && params.height > 0;
+		}
+		else if (key == "power") {
+			isValid = static_cast<bool>(value >> scene.power);
+			params.power = scene.power;
+		}
+		else if (key == "frames") {
+			isValid = static_cast<bool>(value >> scene.frames) && scene.frames > 0;
+		}
+		else {
+			error = path + ":" + std::to_string(lineNumber) + ": unknown key " + key;
+			return false;
+		}
+
+		if (!isValid) {
+			error = path + ":" + std::to_string(lineNumber) + ": bad value for " + key;
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < scenes.size(); i++) {
+		if (!hasIterations[i])
+			scenes[i].params.iterations = c_DefaultIterations[scenes[i].params.fractal];
+	}
+
+	if (scenes.empty()) {
+		error = path + " has no scenes";
+		return false;
+	}
+	return true;
+}
+
+Benchmark::Benchmark(const Settings& settings) : m_Settings(settings)
+{
+	m_QuadVertices = std::make_unique<VertexBuffer>(c_QuadVertices, static_cast<unsigned int>(sizeof(c_QuadVertices)));
+	m_QuadIndices = std::make_unique<IndexBuffer>(c_QuadIndices, static_cast<unsigned int>(sizeof(c_QuadIndices)));
+
+	VertexBufferLayout layout;
+	layout.AddAttribute<float>(2);
+	m_Quad = std::make_unique<VertexArray>();
+	m_Quad->AddBuffer(*m_QuadVertices, layout);
+	m_Quad->Bind();
+	m_QuadIndices->Bind();
+
+	for (int i = 0; i < c_NumFractals; i++) {
+		if (c_ShaderPaths[i])
+			m_Shaders[i] = std::make_unique<Shader>(c_ShaderPaths[i]);
+	}
+	m_MultibrotShaders = std::make_unique<MultibrotShaders>();
+
+	// the bulb's unused samplers still need units of their own to validate
+	Shader& bulb = *m_Shaders[FRACTAL_MANDELBULB];
+	bulb.Bind();
+	glUniform1i(bulb.GetLocation("distanceVolume"), DistanceVolume::c_TextureUnit);
+	glUniform1i(bulb.GetLocation("history"), AccumulationBuffer::c_TextureUnit);
+
+	if (m_Settings.useCompute) {
+		m_ComputeRenderer = std::make_unique<ComputeRenderer>();
+		m_Settings.useCompute = m_ComputeRenderer->IsValid();
+	}
+	m_ConePrepass = std::make_unique<ConePrepass>();
+
+	m_Target = std::make_unique<Framebuffer>(1, 1, GL_RGBA8);
+	glGenQueries(1, &m_Query);
+}
+
+Benchmark::~Benchmark()
+{
+	glDeleteQueries(1, &m_Query);
+}
+
+void Benchmark::BindFragmentShader(const BenchmarkScene& scene)
+{
+	const FractalParams& params = scene.params;
+	bool isMultibrot = params.fractal == FRACTAL_MULTIBROT || params.fractal == FRACTAL_MULTICORN;
+	Shader& shader = isMultibrot ? m_MultibrotShaders->Get(params.fractal, params.power) : *m_Shaders[params.fractal];
+
+	shader.Bind();
+	glUniform2i(shader.GetLocation("resolution"), params.width, params.height);
+	glUniform2f(shader.GetLocation("location"), params.location.x, params.location.y);
+	glUniform2f(shader.GetLocation("mousePos"), params.juliaConstant.x, params.juliaConstant.y);
+	glUniform1i(shader.GetLocation("juliaMode"), params.juliaMode);
+	glUniform1f(shader.GetLocation("zoom"), params.zoom);
+	glUniform1i(shader.GetLocation("iterations"), params.iterations);
+	glUniform3fv(shader.GetLocation("color_1"), 1, params.colors[0]);
+	glUniform3fv(shader.GetLocation("color_2"), 1, params.colors[1]);
+	glUniform3fv(shader.GetLocation("color_3"), 1, params.colors[2]);
+	glUniform3fv(shader.GetLocation("color_4"), 1, params.colors[3]);
+
+	if (params.fractal == FRACTAL_MANDELBULB) {
+		bool useCone = m_ConePrepass->IsValid();
+		glUniform1f(shader.GetLocation("power"), scene.power);
+		glUniform1i(shader.GetLocation("coneBlock"), useCone ? m_ConePrepass->GetBlockSize() : 0);
+	}
+	if (isMultibrot)
+		glUniform1f(shader.GetLocation("exponent"), params.power);
+}
+
+void Benchmark::RenderFrame(const BenchmarkScene& scene)
+{
+	const FractalParams& params = scene.params;
+
+	// as the application draws it at its default settings: the bulb with its
+	// cone pre-pass, the 2D fractals on the backend that was asked for where
+	// the compute kernels have them
+	if (params.fractal == FRACTAL_MANDELBULB) {
+		if (m_ConePrepass->IsValid()) {
+			m_ConePrepass->Render(params, scene.power, *m_Quad);
+			m_ConePrepass->GetDepth().Bind(0);
+		}
+		m_Target->Bind();
+		BindFragmentShader(scene);
+		m_Quad->Bind();
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	}
+	else if (m_Settings.useCompute && params.fractal < FRACTAL_MANDELBULB) {
+		m_Target->Bind();
+		m_ComputeRenderer->Render(params, *m_Quad);
+	}
+	else {
+		m_Target->Bind();
+		BindFragmentShader(scene);
+		m_Quad->Bind();
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	}
+}
+
+void Benchmark::Run(const std::vector<BenchmarkScene>& scenes)
+{
+	std::vector<double> gpu;
+	std::vector<double> wall;
+
+	for (const BenchmarkScene& scene : scenes) {
+		const FractalParams& params = scene.params;
+		int frames = scene.frames > 0 ? scene.frames : m_Settings.frames;
+		m_Target->Resize(params.width, params.height);
+
+		for (int i = 0; i < m_Settings.warmupFrames; i++)
+			RenderFrame(scene);
+		glFinish();
+
+		gpu.clear();
+		wall.clear();
+		for (int i = 0; i < frames; i++) {
+			auto start = std::chrono::steady_clock::now();
+			glBeginQuery(GL_TIME_ELAPSED, m_Query);
+			RenderFrame(scene);
+			glEndQuery(GL_TIME_ELAPSED);
+			glFinish();
+			auto end = std::chrono::steady_clock::now();
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(m_Query, GL_QUERY_RESULT, &nanoseconds);
+			gpu.push_back(nanoseconds / 1.0e6);
+			wall.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		Result result;
+		result.scene = scene;
+		result.backend = params.fractal < FRACTAL_MANDELBULB && m_Settings.useCompute ? "compute" : "fragment";
+		result.frames = frames;
+		result.gpu = Summarise(gpu);
+		result.wall = Summarise(wall);
+
+		// throughput from the median wall time, so a stray slow frame does not move
+		// it. Software rasterisers like llvmpipe draw at the flush, which leaves
+		// their timer queries covering little more than the submission
+		double seconds = result.wall.p50 / 1000.0;
+		result.megapixelsPerSecond = params.width * static_cast<double>(params.height) / seconds / 1.0e6;
+		result.iterationsPerFrame = params.fractal == FRACTAL_MANDELBULB ? 0.0 : CountIterations(params);
+		result.gigaiterationsPerSecond = result.iterationsPerFrame / seconds / 1.0e9;
+		m_Results.push_back(result);
+
+		std::printf("%-28s %5dx%-5d  p50 %8.3f ms  p95 %8.3f ms  p99 %8.3f ms  (gpu p50 %8.3f ms)  %8.1f Mpixel/s",
+			scene.name.c_str(), params.width, params.height, result.wall.p50, result.wall.p95, result.wall.p99, result.gpu.p50, result.megapixelsPerSecond);
+		if (result.iterationsPerFrame > 0.0)
+			std::printf("  %6.2f Giter/s", result.gigaiterationsPerSecond);
+		std::printf("\n");
+	}
+}
+
+Benchmark::Stats Benchmark::Summarise(std::vector<double>& milliseconds)
+{
+	Stats stats;
+	if (milliseconds.empty())
+		return stats;
+
+	std::sort(milliseconds.begin(), milliseconds.end());
+	auto percentile = [&](double p) { return milliseconds[static_cast<size_t>(p * (milliseconds.size() - 1) + 0.5)]; };
+
+	stats.min = milliseconds.front();
+	for (double value : milliseconds)
+		stats.mean += value;
+	stats.mean /= milliseconds.size();
+	stats.p50 = percentile(0.50);
+	stats.p95 = percentile(0.95);
+	stats.p99 = percentile(0.99);
+	return stats;
+}
+
+double Benchmark::CountIterations(const FractalParams& params)
+{
+	// a pixel that escapes after n iterations ran n + 1 of them
+	double total = 0.0;
+	for (int y = c_CountStride / 2; y < params.height; y += c_CountStride) {
+		for (int x = c_CountStride / 2; x < params.width; x += c_CountStride) {
+			int iterations = EscapeTime::CountPixel(params, x, y);
+			total += iterations < params.iterations ? iterations + 1 : iterations;
+		}
+	}
+
+	// scale the sample up to the whole image
+	int samplesX = (params.width - c_CountStride / 2 + c_CountStride - 1) / c_CountStride;
+	int samplesY = (params.height - c_CountStride / 2 + c_CountStride - 1) / c_CountStride;
+	if (samplesX < 1 || samplesY < 1)
+		return 0.0;
+	return total * params.width * params.height / (static_cast<double>(samplesX) * samplesY);
+}
+
+bool Benchmark::WriteJSON(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "{\n";
+	out << "  \"vendor\": \"" << EscapeJSON(GetGLString(GL_VENDOR)) << "\",\n";
+	out << "  \"renderer\": \"" << EscapeJSON(GetGLString(GL_RENDERER)) << "\",\n";
+	out << "  \"version\": \"" << EscapeJSON(GetGLString(GL_VERSION)) << "\",\n";
+	out << "  \"warmupFrames\": " << m_Settings.warmupFrames << ",\n";
+	out << "  \"scenes\": [";
+
+	for (size_t i = 0; i < m_Results.size(); i++) {
+		const Result& result = m_Results[i];
+		const FractalParams& params = result.scene.params;
+
+		out << (i == 0 ? "\n" : ",\n") << "    {\n";
+		out << "      \"name\": \"" << EscapeJSON(result.scene.name) << "\",\n";
+		out << "      \"fractal\": \"" << c_FractalNames[params.fractal] << "\",\n";
+		out << "      \"backend\": \"" << result.backend << "\",\n";
+		out << "      \"width\": " << params.width << ",\n";
+		out << "      \"height\": " << params.height << ",\n";
+		out << "      \"iterations\": " << params.iterations << ",\n";
+		if (params.fractal == FRACTAL_MULTIBROT || params.fractal == FRACTAL_MULTICORN)
+			out << "      \"power\": " << params.power << ",\n";
+		out << "      \"frames\": " << result.frames << ",\n";
+		out << "      ";
+		WriteStats(out, "gpuMilliseconds", result.gpu);
+		out << ",\n      ";
+		WriteStats(out, "wallMilliseconds", result.wall);
+		out << ",\n";
+		out << "      \"megapixelsPerSecond\": " << result.megapixelsPerSecond << ",\n";
+
+		// the bulb's work is in its ray steps, not an escape count
+		if (result.iterationsPerFrame > 0.0) {
+			out << "      \"iterationsPerFrame\": " << result.iterationsPerFrame << ",\n";
+			out << "      \"gigaiterationsPerSecond\": " << result.gigaiterationsPerSecond << "\n";
+		}
+		else {
+			out << "      \"iterationsPerFrame\": null,\n";
+			out << "      \"gigaiterationsPerSecond\": null\n";
+		}
+		out << "    }";
+	}
+
+	out << "\n  ]\n}\n";
+	return static_cast<bool>(out);
+}
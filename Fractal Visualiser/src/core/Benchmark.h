@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/FractalParams.h>
+#include <renderer/ComputeRenderer.h>
+#include <renderer/ConePrepass.h>
+#include <renderer/Framebuffer.h>
+#include <renderer/MultibrotShaders.h>
+#include <shader/Shader.h>
+#include <vertex/IndexBuffer.h>
+#include <vertex/VertexArray.h>
+#include <vertex/VertexBuffer.h>
+
+// One view to time, read from a scene file.
+struct BenchmarkScene {
+	std::string name;
+	FractalParams params;
+	// the Mandelbulb's; the Multibrot and Multicorn take theirs from params
+	float power = 8.0f;
+	// 0 uses the suite's frame count
+	int frames = 0;
+};
+
+// Renders each scene a number of times through the same shaders and renderers
+// the application uses, into an offscreen target at the scene's resolution, and
+// reports frame time percentiles and throughput as JSON. Every frame is timed
+// on its own, with a GL_TIME_ELAPSED query and with the wall clock up to
+// glFinish, so results are not smeared across frames. Throughput comes from
+// the wall clock, which means the same thing on every driver.
+//
+// Needs a current context; the caller decides how it is made.
+class Benchmark {
+public:
+	// scene fractals go up to the Multicorn, in FractalType order; the
+	// Buddhabrot and Newton fractal are not drawn by these passes
+	static constexpr int c_NumFractals = FRACTAL_MULTICORN + 1;
+
+	struct Settings {
+		int frames = 30;
+		// rendered first and not recorded, so shader compilation and clocks settle
+		int warmupFrames = 3;
+		bool useCompute = false;
+	};
+
+	struct Stats {
+		double min = 0.0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+	};
+
+	struct Result {
+		BenchmarkScene scene;
+		std::string backend;
+		int frames;
+		Stats gpu;
+		Stats wall;
+		double megapixelsPerSecond;
+		// iterations in one frame, estimated on the CPU; 0 where it is not counted
+		double iterationsPerFrame;
+		double gigaiterationsPerSecond;
+	};
+
+	// scene files are blocks of key = value lines under a [scene name] header:
+	//   fractal = mandelbrot | burningship | tricorn | mandelbulb | multibrot | multicorn
+	//   location = x y, zoom, iterations, julia = x y, resolution = w h, power, frames
+	// power is the Mandelbulb's, or n for the Multibrot and Multicorn
+	// false with a message in error if the file can not be read
+	static bool LoadScenes(const std::string& path, std::vector<BenchmarkScene>& scenes, std::string& error);
+
+	explicit Benchmark(const Settings& settings);
+	~Benchmark();
+
+	void Run(const std::vector<BenchmarkScene>& scenes);
+
+	const std::vector<Result>& GetResults() const { return m_Results; }
+	bool WriteJSON(const std::string& path) const;
+
+private:
+	// binds the target and draws one frame of the scene into it
+	void RenderFrame(const BenchmarkScene& scene);
+	void BindFragmentShader(const BenchmarkScene& scene);
+
+	static Stats Summarise(std::vector<double>& milliseconds);
+	static double CountIterations(const FractalParams& params);
+
+	Settings m_Settings;
+	std::vector<Result> m_Results;
+
+	std::unique_ptr<VertexBuffer> m_QuadVertices;
+	std::unique_ptr<IndexBuffer> m_QuadIndices;
+	std::unique_ptr<VertexArray> m_Quad;
+	// fragment shaders in FractalType order, null for the Multibrot and Multicorn
+	std::unique_ptr<Shader> m_Shaders[c_NumFractals];
+	std::unique_ptr<MultibrotShaders> m_MultibrotShaders;
+	std::unique_ptr<ComputeRenderer> m_ComputeRenderer;
+	std::unique_ptr<ConePrepass> m_ConePrepass;
+	std::unique_ptr<Framebuffer> m_Target;
+	unsigned int m_Query = 0;
+};
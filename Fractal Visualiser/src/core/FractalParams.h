@@ -0,0 +1,69 @@
+#pragma once
+
+struct Vec2 {
+	float x;
+	float y;
+};
+
+// order matches the fractal selector in the control menu
+enum FractalType {
+	FRACTAL_MANDELBROT = 0,
+	FRACTAL_BURNINGSHIP = 1,
+	FRACTAL_TRICORN = 2,
+	FRACTAL_MANDELBULB = 3,
+	// drawn on the CPU by BuddhabrotRenderer, not by a shader
+	FRACTAL_BUDDHABROT = 4,
+	// z^n + c for a real n, and the same with z conjugated first
+	FRACTAL_MULTIBROT = 5,
+	FRACTAL_MULTICORN = 6,
+	// Newton's method on a polynomial, coloured by the root each point goes to
+	FRACTAL_NEWTON = 7
+};
+
+// Polynomial for the Newton fractal, with complex coefficients lowest power
+// first. The roots are found once on the CPU whenever the coefficients change,
+// so iterating only has to check how close z is to each of them.
+struct NewtonPolynomial {
+	static constexpr int c_MaxDegree = 8;
+
+	int degree = 3;
+	Vec2 coefficients[c_MaxDegree + 1] = { { -1.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, { 1.0f, 0.0f } };
+
+	// filled in by Newton::FindRoots; fewer than degree if the top coefficients are 0
+	int rootCount = 0;
+	Vec2 roots[c_MaxDegree] = {};
+};
+
+// Everything a renderer needs to draw one frame, copied out of the Application
+// so that passes other than the selected fragment shader see the same view.
+struct FractalParams {
+	// the fractals drawn by escape time in the plane, which the CPU kernels and auto iterations cover
+	static bool IsEscapeTime(int fractal)
+	{
+		return fractal < FRACTAL_MANDELBULB || fractal == FRACTAL_MULTIBROT || fractal == FRACTAL_MULTICORN;
+	}
+
+	// the fractals whose cap the iteration controller can pick: the escape time
+	// ones, and the Newton fractal whose cap is hit by points that never settle
+	static bool IsAutoIterated(int fractal)
+	{
+		return IsEscapeTime(fractal) || fractal == FRACTAL_NEWTON;
+	}
+
+	int fractal = FRACTAL_MANDELBROT;
+	int width = 1280;
+	int height = 720;
+
+	Vec2 location = { 0.0f, 0.0f };
+	Vec2 juliaConstant = { 0.0f, 0.0f };
+	bool juliaMode = false;
+	float zoom = 2.0f;
+	int iterations = 200;
+	// n for the Multibrot and Multicorn
+	float power = 3.0f;
+	NewtonPolynomial newton;
+
+	float colors[4][3] = {
+		{0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 0.33f, 0.67f}
+	};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+
+// The newest value from one producer thread for one consumer thread, with no
+// locks. Three copies go round: the producer writes one, the consumer reads
+// another, and the third holds the newest stored value. Each side swaps its
+// copy with the third through one atomic exchange, so a store never waits and
+// replaces any value the consumer has not taken yet.
+template <typename T>
+class LatestValue {
+public:
+	// producer only
+	void Store(const T& value)
+	{
+		m_Items[m_Back] = value;
+		m_Back = m_Middle.exchange(m_Back | c_New, std::memory_order_acq_rel) & c_IndexMask;
+	}
+
+	// consumer only; false when nothing was stored since the last take
+	bool Take(T& value)
+	{
+		if (!(m_Middle.load(std::memory_order_relaxed) & c_New))
+			return false;
+
+		m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & c_IndexMask;
+		value = m_Items[m_Front];
+		return true;
+	}
+
+private:
+	static constexpr int c_IndexMask = 3;
+	// set in m_Middle while the value there has not been taken
+	static constexpr int c_New = 4;
+
+	T m_Items[3];
+	// producer only
+	int m_Back = 0;
+	// apart, so the two threads do not share a cache line
+	alignas(64) std::atomic<int> m_Middle{ 1 };
+	// consumer only
+	alignas(64) int m_Front = 2;
+};
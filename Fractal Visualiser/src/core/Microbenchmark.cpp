@@ -0,0 +1,249 @@
+#include "Microbenchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#include <core/FractalParams.h>
+#include <cpu/EscapeTime.h>
+
+namespace {
+	const char* c_FractalNames[Microbenchmark::c_NumFractals] = { "mandelbrot", "burningship", "tricorn" };
+	const char* c_SetNames[Microbenchmark::NUM_SETS] = { "interior", "exterior", "boundary" };
+
+	// all three sets lie in this disc; sampling the square around it would fill
+	// the exterior set with corners that escape on the first iteration
+	const double c_SampleRadius = 2.0;
+	// sampling gives up here if a set can not be filled, the sets are then short
+	const int c_MaxSamples = 1 << 22;
+	const unsigned int c_Seed = 1234;
+	// boundary points are bisected until this close to an interior point; a few
+	// float steps apart at the scale of the sets, so the float kernels see it
+	const double c_BoundaryDistance = 1.0e-6;
+
+	// a pixel that escapes after n iterations ran n + 1 of them
+	double CountIterations(const std::vector<int>& counts, int maxIterations)
+	{
+		double total = 0.0;
+		for (int count : counts)
+			total += count < maxIterations ? count + 1 : count;
+		return total;
+	}
+}
+
+const char* Microbenchmark::GetSetName(PointSet set)
+{
+	return set >= 0 && set < NUM_SETS ? c_SetNames[set] : "unknown";
+}
+
+Microbenchmark::Microbenchmark(const Settings& settings) : m_Settings(settings)
+{
+	unsigned int maxThreads = m_Settings.maxThreads ? m_Settings.maxThreads : std::thread::hardware_concurrency();
+	maxThreads = std::max(maxThreads, 1u);
+
+	// doubling up to every core, and every core itself
+	for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+		m_ThreadCounts.push_back(threads);
+	m_ThreadCounts.push_back(maxThreads);
+}
+
+void Microbenchmark::BuildPoints(int fractal)
+{
+	int maxIterations = m_Settings.iterations;
+	int exteriorLimit = std::max(maxIterations / 8, 1);
+	auto classify = [&](double cx, double cy) {
+		return EscapeTime::Count(fractal, static_cast<float>(cx), static_cast<float>(cy), 0.0f, 0.0f, maxIterations);
+	};
+
+	std::mt19937 random(c_Seed + fractal);
+	auto uniform = [&]() { return (random() / 4294967296.0 * 2.0 - 1.0) * c_SampleRadius; };
+
+	for (EscapePoints& points : m_Sets) {
+		points.cx.clear();
+		points.cy.clear();
+	}
+	EscapePoints& interior = m_Sets[SET_INTERIOR];
+	EscapePoints& exterior = m_Sets[SET_EXTERIOR];
+	EscapePoints& boundary = m_Sets[SET_BOUNDARY];
+
+	for (int sample = 0; sample < c_MaxSamples; sample++) {
+		if (interior.GetCount() >= m_Settings.points && exterior.GetCount() >= m_Settings.points)
+			break;
+
+		double cx = uniform();
+		double cy = uniform();
+		if (cx * cx + cy * cy > c_SampleRadius * c_SampleRadius)
+			continue;
+		int count = classify(cx, cy);
+		EscapePoints* points = count >= maxIterations ? &interior : count < exteriorLimit ? &exterior : nullptr;
+		if (points && points->GetCount() < m_Settings.points) {
+			points->cx.push_back(cx);
+			points->cy.push_back(cy);
+		}
+	}
+
+	// each boundary point sits between a random interior and exterior pair
+	if (interior.GetCount() > 0 && exterior.GetCount() > 0) {
+		for (int i = 0; i < m_Settings.points; i++) {
+			int inside = static_cast<int>(random() % interior.GetCount());
+			int outside = static_cast<int>(random() % exterior.GetCount());
+			double inX = interior.cx[inside];
+			double inY = interior.cy[inside];
+			double outX = exterior.cx[outside];
+			double outY = exterior.cy[outside];
+
+			while (std::hypot(outX - inX, outY - inY) > c_BoundaryDistance) {
+				double midX = 0.5 * (inX + outX);
+				double midY = 0.5 * (inY + outY);
+				if (classify(midX, midY) >= maxIterations) {
+					inX = midX;
+					inY = midY;
+				}
+				else {
+					outX = midX;
+					outY = midY;
+				}
+			}
+			boundary.cx.push_back(outX);
+			boundary.cy.push_back(outY);
+		}
+	}
+
+	// the perturbation kernel follows one interior point's orbit
+	if (interior.GetCount() > 0)
+		m_Reference = EscapeKernels::ComputeReference(fractal, interior.cx[0], interior.cy[0], maxIterations);
+	else
+		m_Reference = EscapeKernels::ComputeReference(fractal, 0.0, 0.0, maxIterations);
+}
+
+double Microbenchmark::Time(EscapeKernels::Kernel kernel, int fractal, const EscapePoints& points, unsigned int threads, int passes) const
+{
+	int count = points.GetCount();
+	int blocksPerPass = (count + c_BlockSize - 1) / c_BlockSize;
+	int totalBlocks = blocksPerPass * passes;
+	std::atomic<int> nextBlock(0);
+
+	auto work = [&]() {
+		// each thread has its own counts, they are thrown away
+		std::vector<int> counts(count);
+		for (int block = nextBlock++; block < totalBlocks; block = nextBlock++) {
+			int begin = (block % blocksPerPass) * c_BlockSize;
+			int end = std::min(begin + c_BlockSize, count);
+			EscapeKernels::Run(kernel, fractal, points, m_Reference, begin, end, m_Settings.iterations, counts.data());
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> helpers;
+	for (unsigned int i = 1; i < threads; i++)
+		helpers.emplace_back(work);
+	work();
+	for (std::thread& helper : helpers)
+		helper.join();
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void Microbenchmark::Run()
+{
+	// ns per iteration for each thread count, then the speedup on every thread
+	std::printf("%-12s %-9s %-13s %10s %7s", "fractal", "set", "kernel", "Miter/pass", "agree");
+	for (unsigned int threads : m_ThreadCounts)
+		std::printf(" %6ut", threads);
+	std::printf(" %8s\n", "speedup");
+
+	std::vector<int> counts;
+	std::vector<int> scalarCounts;
+
+	for (int fractal = 0; fractal < c_NumFractals; fractal++) {
+		BuildPoints(fractal);
+
+		for (int set = 0; set < NUM_SETS; set++) {
+			const EscapePoints& points = m_Sets[set];
+			if (points.GetCount() == 0)
+				continue;
+
+			for (int kernel = 0; kernel < EscapeKernels::NUM_KERNELS; kernel++) {
+				// one pass on this thread for the counts, which also warms the caches
+				counts.assign(points.GetCount(), 0);
+				auto start = std::chrono::steady_clock::now();
+				EscapeKernels::Run(static_cast<EscapeKernels::Kernel>(kernel), fractal, points, m_Reference, 0, points.GetCount(), m_Settings.iterations, counts.data());
+				double passMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				if (kernel == EscapeKernels::KERNEL_SCALAR)
+					scalarCounts = counts;
+
+				Result result;
+				result.fractal = fractal;
+				result.set = static_cast<PointSet>(set);
+				result.kernel = static_cast<EscapeKernels::Kernel>(kernel);
+				result.iterationsPerPass = CountIterations(counts, m_Settings.iterations);
+				int agreeing = 0;
+				for (size_t i = 0; i < counts.size(); i++)
+					agreeing += counts[i] == scalarCounts[i];
+				result.scalarAgreement = static_cast<double>(agreeing) / counts.size();
+
+				int passes = std::max(1, static_cast<int>(std::ceil(m_Settings.minMilliseconds / std::max(passMilliseconds, 0.001))));
+				double iterations = result.iterationsPerPass * passes;
+				double singleMilliseconds = 0.0;
+				for (unsigned int threads : m_ThreadCounts) {
+					double milliseconds = Time(result.kernel, fractal, points, threads, passes);
+					if (threads == 1)
+						singleMilliseconds = milliseconds;
+
+					Timing timing;
+					timing.threads = threads;
+					timing.nanosecondsPerIteration = milliseconds * 1.0e6 / iterations;
+					timing.speedup = singleMilliseconds > 0.0 ? singleMilliseconds / milliseconds : 1.0;
+					result.timings.push_back(timing);
+				}
+				m_Results.push_back(result);
+
+				std::printf("%-12s %-9s %-13s %10.2f %6.1f%%", c_FractalNames[fractal], c_SetNames[set],
+					EscapeKernels::GetName(result.kernel), result.iterationsPerPass / 1.0e6, 100.0 * result.scalarAgreement);
+				for (const Timing& timing : result.timings)
+					std::printf(" %7.3f", timing.nanosecondsPerIteration);
+				std::printf(" %7.1fx\n", result.timings.back().speedup);
+			}
+		}
+	}
+}
+
+bool Microbenchmark::WriteJSON(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "{\n";
+	out << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "  \"points\": " << m_Settings.points << ",\n";
+	out << "  \"iterations\": " << m_Settings.iterations << ",\n";
+	out << "  \"results\": [";
+
+	for (size_t i = 0; i < m_Results.size(); i++) {
+		const Result& result = m_Results[i];
+		out << (i == 0 ? "\n" : ",\n") << "    {\n";
+		out << "      \"fractal\": \"" << c_FractalNames[result.fractal] << "\",\n";
+		out << "      \"set\": \"" << c_SetNames[result.set] << "\",\n";
+		out << "      \"kernel\": \"" << EscapeKernels::GetName(result.kernel) << "\",\n";
+		out << "      \"iterationsPerPass\": " << result.iterationsPerPass << ",\n";
+		out << "      \"scalarAgreement\": " << result.scalarAgreement << ",\n";
+		out << "      \"threads\": [";
+		for (size_t j = 0; j < result.timings.size(); j++) {
+			const Timing& timing = result.timings[j];
+			out << (j == 0 ? "\n" : ",\n") << "        { \"threads\": " << timing.threads
+				<< ", \"nanosecondsPerIteration\": " << timing.nanosecondsPerIteration
+				<< ", \"speedup\": " << timing.speedup << " }";
+		}
+		out << "\n      ]\n    }";
+	}
+
+	out << "\n  ]\n}\n";
+	return static_cast<bool>(out);
+}
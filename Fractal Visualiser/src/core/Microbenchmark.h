@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cpu/EscapeKernels.h>
+
+// Times each CPU escape time kernel on each 2D formula, over point sets with
+// known escape behaviour, from one thread up to every core. No GL is involved,
+// so it measures the arithmetic alone:
+//   interior  points that reach the iteration cap
+//   exterior  points that escape within the first eighth of the cap
+//   boundary  points just outside the set, found by bisecting between an
+//             interior and an exterior point, which escape late and unevenly
+// The sets come from a fixed seed so runs compare. Each kernel reports ns per
+// iteration from its own counts, and the share of points where it agrees with
+// the scalar kernel, which shows where the other number formats part ways.
+class Microbenchmark {
+public:
+	enum PointSet {
+		SET_INTERIOR = 0,
+		SET_EXTERIOR,
+		SET_BOUNDARY,
+		NUM_SETS
+	};
+
+	static constexpr int c_NumFractals = 3;
+	// points a thread takes from the shared counter at a time
+	static constexpr int c_BlockSize = 64;
+
+	struct Settings {
+		int points = 4096;
+		int iterations = 1000;
+		// 0 goes up to every core
+		unsigned int maxThreads = 0;
+		// single thread time to aim for, the point set is run as many times as it takes
+		double minMilliseconds = 100.0;
+	};
+
+	struct Timing {
+		unsigned int threads;
+		double nanosecondsPerIteration;
+		// over the single thread time
+		double speedup;
+	};
+
+	struct Result {
+		int fractal;
+		PointSet set;
+		EscapeKernels::Kernel kernel;
+		double iterationsPerPass;
+		// share of points with the scalar kernel's escape count
+		double scalarAgreement;
+		std::vector<Timing> timings;
+	};
+
+	static const char* GetSetName(PointSet set);
+
+	explicit Microbenchmark(const Settings& settings);
+
+	void Run();
+
+	const std::vector<Result>& GetResults() const { return m_Results; }
+	bool WriteJSON(const std::string& path) const;
+
+private:
+	void BuildPoints(int fractal);
+	// wall time of running the set passes times over, in milliseconds
+	double Time(EscapeKernels::Kernel kernel, int fractal, const EscapePoints& points, unsigned int threads, int passes) const;
+
+	Settings m_Settings;
+	std::vector<unsigned int> m_ThreadCounts;
+	std::vector<Result> m_Results;
+
+	EscapePoints m_Sets[NUM_SETS];
+	ReferenceOrbit m_Reference;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+class PngWriter {
+public:
+	// pixels are 8 bit RGB, bottom row first as glReadPixels returns them
+	static bool Save(const char* filename, const uint8_t* pixels, int w, int h);
+};
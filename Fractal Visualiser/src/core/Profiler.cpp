@@ -0,0 +1,165 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "Profiler.h"
+#include <core/AllocationCounter.h>
+#include <core/Trace.h>
+#include <glad/glad.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+int Profiler::AddSection(const std::string& name, Clock clock)
+{
+	m_Sections.emplace_back();
+	Section& section = m_Sections.back();
+	section.name = name;
+	section.traceName = Trace::Intern(name);
+	section.clock = clock;
+	if (clock == Clock::GPU)
+		section.timer = std::make_unique<GpuTimer>();
+
+	m_Sorted.reserve(c_HistorySize);
+	return static_cast<int>(m_Sections.size()) - 1;
+}
+
+void Profiler::Begin(int section, int tag)
+{
+	Section& s = m_Sections[section];
+	if (s.clock == Clock::GPU)
+		s.timer->Begin(tag);
+	else
+		s.start = std::chrono::steady_clock::now();
+}
+
+void Profiler::End(int section)
+{
+	Section& s = m_Sections[section];
+	if (s.clock == Clock::GPU) {
+		s.timer->End();
+		return;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<double, std::milli> elapsed = end - s.start;
+	Record(s, elapsed.count());
+	Trace::AddSpan(s.traceName, s.start, end);
+}
+
+void Profiler::Update()
+{
+	// GPU times are placed on the trace's CPU timeline with a fresh clock pair
+	if (Trace::IsRecording()) {
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		Trace::CalibrateGpu(static_cast<uint64_t>(gpuNow), std::chrono::steady_clock::now());
+	}
+
+	for (Section& section : m_Sections) {
+		section.resultCount = 0;
+		if (section.clock != Clock::GPU)
+			continue;
+
+		double milliseconds;
+		int tag;
+		uint64_t start;
+		while (section.timer->Poll(milliseconds, tag, start)) {
+			Record(section, milliseconds);
+			Trace::AddGpuSpan(section.traceName, start, static_cast<uint64_t>(milliseconds * 1e6));
+			if (section.resultCount < GpuTimer::c_NumQueries)
+				section.results[section.resultCount++] = { milliseconds, tag };
+		}
+	}
+}
+
+int Profiler::GetResults(int section, const GpuResult*& results) const
+{
+	const Section& s = m_Sections[section];
+	results = s.results;
+	return s.resultCount;
+}
+
+void Profiler::Record(Section& section, double milliseconds)
+{
+	section.history[section.head] = static_cast<float>(milliseconds);
+	section.head = (section.head + 1) % c_HistorySize;
+	section.count = std::min(section.count + 1, c_HistorySize);
+}
+
+void Profiler::DrawOverlay(bool* isOpen)
+{
+	ImGui::SetNextWindowSize({ 0, 0 });
+	if (!ImGui::Begin("Performance", isOpen)) {
+		ImGui::End();
+		return;
+	}
+
+	for (const Section& section : m_Sections) {
+		// CPU and GPU sections can share a name
+		ImGui::PushID(&section);
+		if (section.count == 0) {
+			ImGui::TextDisabled("%s: no samples yet", section.name.c_str());
+			ImGui::PopID();
+			continue;
+		}
+
+		m_Sorted.assign(section.history, section.history + section.count);
+		auto percentile = [&](float p) {
+			auto nth = m_Sorted.begin() + static_cast<size_t>(p * (m_Sorted.size() - 1));
+			std::nth_element(m_Sorted.begin(), nth, m_Sorted.end());
+			return *nth;
+		};
+		float p50 = percentile(0.50f);
+		float p95 = percentile(0.95f);
+		float p99 = percentile(0.99f);
+
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "p50 %.2f  p95 %.2f  p99 %.2f ms", p50, p95, p99);
+
+		// the ring starts at head once it has wrapped
+		int offset = section.count == c_HistorySize ? section.head : 0;
+		ImGui::Text("%s (%s)", section.name.c_str(), section.clock == Clock::GPU ? "GPU" : "CPU");
+		ImGui::PlotLines("##history", section.history, section.count, offset, overlay, 0.0f, p99 * 1.25f, { 320, 48 });
+		ImGui::PopID();
+	}
+
+	if (ImGui::Button("Export CSV")) {
+		AllocationCounter::Exempt exempt;
+		if (ExportCSV("frame_times.csv"))
+			std::cout << "Wrote frame_times.csv" << std::endl;
+	}
+
+	// the trace keeps the newest spans of every thread, so it can stay on and be saved after a hitch
+	bool isRecording = Trace::IsRecording();
+	if (ImGui::Checkbox("Record Trace", &isRecording))
+		Trace::SetRecording(isRecording);
+	ImGui::SameLine();
+	if (ImGui::Button("Save Trace")) {
+		AllocationCounter::Exempt exempt;
+		if (Trace::Export("trace.json"))
+			std::cout << "Wrote trace.json" << std::endl;
+	}
+
+	ImGui::End();
+}
+
+bool Profiler::ExportCSV(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "section,clock,sample,milliseconds\n");
+	for (const Section& section : m_Sections) {
+		int first = section.count == c_HistorySize ? section.head : 0;
+		for (int i = 0; i < section.count; i++) {
+			float value = section.history[(first + i) % c_HistorySize];
+			fprintf(file, "%s,%s,%d,%.4f\n", section.name.c_str(), section.clock == Clock::GPU ? "GPU" : "CPU", i, value);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
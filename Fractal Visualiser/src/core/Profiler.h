@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <renderer/GpuTimer.h>
+
+// Named frame timings. CPU sections are timed with a steady clock, GPU
+// sections with GpuTimer queries that are read back a few frames later. Each
+// section keeps a rolling history, which the overlay draws as a graph with
+// its p50, p95 and p99, and which can be written out as CSV. While a trace is
+// recording, every measurement also goes to it as a span.
+//
+// GL_TIME_ELAPSED queries cannot overlap, so GPU sections must not nest.
+class Profiler {
+public:
+	static constexpr int c_HistorySize = 300;
+
+	enum class Clock { CPU, GPU };
+
+	struct GpuResult {
+		double milliseconds = 0.0;
+		int tag = 0;
+	};
+
+	// returns the id passed to Begin and End
+	int AddSection(const std::string& name, Clock clock);
+
+	// the tag is stored with a GPU result, for consumers that need to know
+	// what kind of frame a late measurement came from
+	void Begin(int section, int tag = 0);
+	void End(int section);
+
+	// reads back finished GPU queries, once a frame
+	void Update();
+
+	// every GPU result that arrived in the last Update, oldest first; several
+	// can come back at once after a slow frame
+	int GetResults(int section, const GpuResult*& results) const;
+
+	void DrawOverlay(bool* isOpen);
+	// one row per sample, oldest first: section, sample, milliseconds
+	bool ExportCSV(const std::string& path) const;
+
+private:
+	struct Section {
+		std::string name;
+		const char* traceName;
+		Clock clock;
+		std::unique_ptr<GpuTimer> timer;
+		std::chrono::steady_clock::time_point start;
+
+		float history[c_HistorySize] = {};
+		int head = 0;
+		int count = 0;
+
+		// no more than the timer has queries in flight
+		GpuResult results[GpuTimer::c_NumQueries];
+		int resultCount = 0;
+	};
+
+	void Record(Section& section, double milliseconds);
+
+	std::vector<Section> m_Sections;
+	// scratch for the percentiles, sized once
+	std::vector<float> m_Sorted;
+};
@@ -0,0 +1,246 @@
+#include "Regression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <core/PngWriter.h>
+#include <cpu/EscapeTime.h>
+#include <renderer/GL43.h>
+#include <vertex/VertexBufferLayout.h>
+
+namespace {
+	const float c_QuadVertices[] = { 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f };
+	const unsigned int c_QuadIndices[] = { 0, 1, 3, 1, 2, 3 };
+
+	const char* c_ShaderPaths[FRACTAL_MANDELBULB] = {
+		"res/shaders/mandelbrot.shader", "res/shaders/burningship.shader", "res/shaders/tricorn.shader"
+	};
+
+	// an escaped pixel's smooth count is below iterations - 1, a capped one is at
+	// iterations or above, or NaN when z ended inside the unit circle
+	bool IsCapped(float value, int iterations)
+	{
+		return !(value < iterations - 1.0f);
+	}
+
+	// scene names are free text, file names are kept to letters, digits and _
+	std::string ToFileName(const std::string& name)
+	{
+		std::string fileName;
+		for (char c : name) {
+			bool isSafe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+			fileName += isSafe ? c : '_';
+		}
+		return fileName;
+	}
+}
+
+Regression::Regression(const Settings& settings) : m_Settings(settings)
+{
+	m_QuadVertices = std::make_unique<VertexBuffer>(c_QuadVertices, static_cast<unsigned int>(sizeof(c_QuadVertices)));
+	m_QuadIndices = std::make_unique<IndexBuffer>(c_QuadIndices, static_cast<unsigned int>(sizeof(c_QuadIndices)));
+
+	VertexBufferLayout layout;
+	layout.AddAttribute<float>(2);
+	m_Quad = std::make_unique<VertexArray>();
+	m_Quad->AddBuffer(*m_QuadVertices, layout);
+	m_Quad->Bind();
+	m_QuadIndices->Bind();
+
+	for (int i = 0; i < FRACTAL_MANDELBULB; i++)
+		m_Shaders[i] = std::make_unique<Shader>(c_ShaderPaths[i], "#define ITERATION_OUTPUT\n");
+	m_MultibrotShaders = std::make_unique<MultibrotShaders>("#define ITERATION_OUTPUT\n");
+
+	if (m_Settings.useCompute) {
+		m_ComputeRenderer = std::make_unique<ComputeRenderer>();
+		m_Settings.useCompute = m_ComputeRenderer->IsValid();
+	}
+
+	m_Target = std::make_unique<Framebuffer>(1, 1, GL_R32F);
+}
+
+bool Regression::UsesCompute(const FractalParams& params) const
+{
+	return m_Settings.useCompute && params.fractal < FRACTAL_MANDELBULB;
+}
+
+void Regression::RenderGpu(const FractalParams& params, std::vector<float>& values)
+{
+	values.resize(static_cast<size_t>(params.width) * params.height);
+
+	if (UsesCompute(params)) {
+		// the compute kernels already write smooth counts, read their image straight back
+		m_ComputeRenderer->Dispatch(params);
+		glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+		m_ComputeRenderer->GetIterationBuffer().Bind(0);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, values.data());
+		return;
+	}
+
+	bool isMultibrot = params.fractal == FRACTAL_MULTIBROT || params.fractal == FRACTAL_MULTICORN;
+	Shader& shader = isMultibrot ? m_MultibrotShaders->Get(params.fractal, params.power) : *m_Shaders[params.fractal];
+	m_Target->Resize(params.width, params.height);
+	m_Target->Bind();
+
+	shader.Bind();
+	glUniform2i(shader.GetLocation("resolution"), params.width, params.height);
+	glUniform2f(shader.GetLocation("location"), params.location.x, params.location.y);
+	glUniform2f(shader.GetLocation("mousePos"), params.juliaConstant.x, params.juliaConstant.y);
+	glUniform1i(shader.GetLocation("juliaMode"), params.juliaMode);
+	glUniform1f(shader.GetLocation("zoom"), params.zoom);
+	glUniform1i(shader.GetLocation("iterations"), params.iterations);
+	if (isMultibrot)
+		glUniform1f(shader.GetLocation("exponent"), params.power);
+
+	m_Quad->Bind();
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	glReadPixels(0, 0, params.width, params.height, GL_RED, GL_FLOAT, values.data());
+}
+
+void Regression::RenderCpu(const FractalParams& params, std::vector<float>& values, std::vector<uint8_t>& isStable) const
+{
+	size_t size = static_cast<size_t>(params.width) * params.height;
+	values.resize(size);
+	isStable.resize(size);
+
+	for (int y = 0; y < params.height; y++) {
+		for (int x = 0; x < params.width; x++) {
+			float cx, cy, zx, zy;
+			EscapeTime::MapPixel(params, x, y, cx, cy, zx, zy);
+			float value = EscapeTime::SmoothCount(params.fractal, cx, cy, zx, zy, params.iterations, params.power);
+
+			// nudged up in x, up in y, and down in both
+			float nudges[3][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, -1.0f } };
+			bool isPixelStable = true;
+			for (const float* nudge : nudges) {
+				float ncx = nudge[0] == 0.0f ? cx : std::nextafter(cx, nudge[0] * INFINITY);
+				float ncy = nudge[1] == 0.0f ? cy : std::nextafter(cy, nudge[1] * INFINITY);
+				float nzx = nudge[0] == 0.0f ? zx : std::nextafter(zx, nudge[0] * INFINITY);
+				float nzy = nudge[1] == 0.0f ? zy : std::nextafter(zy, nudge[1] * INFINITY);
+				if (!IsMatch(EscapeTime::SmoothCount(params.fractal, ncx, ncy, nzx, nzy, params.iterations, params.power), value, params.iterations)) {
+					isPixelStable = false;
+					break;
+				}
+			}
+
+			size_t i = static_cast<size_t>(y) * params.width + x;
+			values[i] = value;
+			isStable[i] = isPixelStable;
+		}
+	}
+}
+
+bool Regression::IsMatch(float gpu, float cpu, int iterations) const
+{
+	bool isGpuCapped = IsCapped(gpu, iterations);
+	if (isGpuCapped != IsCapped(cpu, iterations))
+		return false;
+	return isGpuCapped || std::fabs(gpu - cpu) <= m_Settings.tolerance;
+}
+
+Regression::Result Regression::Compare(const BenchmarkScene& scene, const std::vector<float>& gpu, const std::vector<float>& cpu, const std::vector<uint8_t>& isStable) const
+{
+	const FractalParams& params = scene.params;
+
+	Result result;
+	result.scene = scene;
+	result.backend = UsesCompute(params) ? "compute" : "fragment";
+	result.isSkipped = false;
+	result.mismatched = 0;
+	result.unstable = 0;
+	result.isTooUnstable = false;
+	result.maxDifference = 0.0f;
+
+	// matching pixels are a dim grey ramp of the reference so the view can be
+	// recognised, unstable ones dark blue, mismatches red, and pixels capped on
+	// one side only yellow
+	std::vector<uint8_t> diff(cpu.size() * 3);
+	for (size_t i = 0; i < cpu.size(); i++) {
+		uint8_t* pixel = &diff[i * 3];
+		bool isCpuCapped = IsCapped(cpu[i], params.iterations);
+
+		if (!isStable[i]) {
+			result.unstable++;
+			pixel[0] = 0;
+			pixel[1] = 0;
+			pixel[2] = 96;
+		}
+		else if (isCpuCapped != IsCapped(gpu[i], params.iterations)) {
+			result.mismatched++;
+			pixel[0] = 255;
+			pixel[1] = 255;
+			pixel[2] = 0;
+		}
+		else if (isCpuCapped) {
+			pixel[0] = pixel[1] = pixel[2] = 0;
+		}
+		else {
+			float difference = std::fabs(gpu[i] - cpu[i]);
+			result.maxDifference = std::max(result.maxDifference, difference);
+			if (difference > m_Settings.tolerance) {
+				result.mismatched++;
+				pixel[0] = 255;
+				pixel[1] = 0;
+				pixel[2] = 0;
+			}
+			else {
+				float shade = 6.0f * cpu[i] / params.iterations;
+				pixel[0] = pixel[1] = pixel[2] = static_cast<uint8_t>(32.0f + 64.0f * (shade - std::floor(shade)));
+			}
+		}
+	}
+
+	result.isTooUnstable = result.unstable > m_Settings.maxUnstable * cpu.size();
+	result.isPassed = !result.isTooUnstable && result.mismatched <= m_Settings.maxMismatch * (cpu.size() - result.unstable);
+
+	if (!m_Settings.outputDirectory.empty()) {
+		result.diffPath = m_Settings.outputDirectory + "/" + ToFileName(scene.name) + "_diff.png";
+		if (!PngWriter::Save(result.diffPath.c_str(), diff.data(), params.width, params.height))
+			result.diffPath.clear();
+	}
+	return result;
+}
+
+bool Regression::Run(const std::vector<BenchmarkScene>& scenes)
+{
+	bool isPassed = true;
+	std::vector<float> gpu;
+	std::vector<float> cpu;
+	std::vector<uint8_t> isStable;
+
+	for (const BenchmarkScene& scene : scenes) {
+		const FractalParams& params = scene.params;
+		if (!FractalParams::IsEscapeTime(params.fractal)) {
+			Result result;
+			result.scene = scene;
+			result.isSkipped = true;
+			result.isPassed = true;
+			result.mismatched = 0;
+			result.unstable = 0;
+			result.isTooUnstable = false;
+			result.maxDifference = 0.0f;
+			m_Results.push_back(result);
+			std::printf("%-28s skipped, the Mandelbulb has no CPU escape time reference\n", scene.name.c_str());
+			continue;
+		}
+
+		RenderGpu(params, gpu);
+		RenderCpu(params, cpu, isStable);
+		Result result = Compare(scene, gpu, cpu, isStable);
+		m_Results.push_back(result);
+		isPassed = isPassed && result.isPassed;
+
+		int checked = static_cast<int>(cpu.size()) - result.unstable;
+		double share = checked > 0 ? 100.0 * result.mismatched / checked : 0.0;
+		std::printf("%-28s %s  %-8s  %6d of %6d pixels off (%.3f%%), %6d unstable  max difference %.4g",
+			scene.name.c_str(), result.isPassed ? "pass" : "FAIL", result.backend.c_str(), result.mismatched, checked, share, result.unstable, result.maxDifference);
+		if (result.isTooUnstable)
+			std::printf("  too many unstable");
+		if (!result.diffPath.empty())
+			std::printf("  %s", result.diffPath.c_str());
+		std::printf("\n");
+	}
+
+	return isPassed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/Benchmark.h>
+#include <renderer/ComputeRenderer.h>
+#include <renderer/Framebuffer.h>
+#include <renderer/MultibrotShaders.h>
+#include <shader/Shader.h>
+#include <vertex/IndexBuffer.h>
+#include <vertex/VertexArray.h>
+#include <vertex/VertexBuffer.h>
+
+// Checks the GPU escape time output against EscapeTime on the CPU, so changes
+// to the shaders can not quietly move pixels. Each 2D scene is drawn through
+// the fragment shaders built with ITERATION_OUTPUT, or through the compute
+// backend, and the smooth iteration counts are read back and compared pixel by
+// pixel. Pixels that hit the cap only need to hit it on both sides.
+//
+// Shader compilers may fuse and reorder float maths, so the GPU's orbits are
+// not bit for bit the CPU's, and near the set's edge a difference in the last
+// bit grows into a different escape count. Pixels whose reference changes when
+// their starting point moves by one ulp are not fixed by the view at float
+// precision; they are left out of the comparison and shown in the diff. Of the
+// rest, a scene passes while the share past the tolerance stays under the limit.
+// A scene that is mostly unstable checks next to nothing, so it fails once
+// the unstable share goes over a limit of its own.
+//
+// Scenes come from the benchmark's scene files; Mandelbulb scenes are skipped,
+// and the Multibrot and Multicorn always take the fragment path as the compute
+// kernels do not have them.
+// Needs a current context, like Benchmark.
+class Regression {
+public:
+	struct Settings {
+		// largest difference in smooth iterations that still matches
+		float tolerance = 0.05f;
+		// share of pixels allowed past the tolerance
+		float maxMismatch = 0.005f;
+		// share of all pixels allowed to be left out as unstable
+		float maxUnstable = 0.5f;
+		bool useCompute = false;
+		// diff images are written here as <scene>_diff.png, none when empty
+		std::string outputDirectory;
+	};
+
+	struct Result {
+		BenchmarkScene scene;
+		std::string backend;
+		bool isSkipped;
+		bool isPassed;
+		int mismatched;
+		// left out as unstable at float precision
+		int unstable;
+		bool isTooUnstable;
+		// largest difference over the pixels that escaped on both sides
+		float maxDifference;
+		std::string diffPath;
+	};
+
+	explicit Regression(const Settings& settings);
+
+	// true when every scene that was checked passed
+	bool Run(const std::vector<BenchmarkScene>& scenes);
+
+	const std::vector<Result>& GetResults() const { return m_Results; }
+
+private:
+	bool UsesCompute(const FractalParams& params) const;
+	// bottom row first, as glReadPixels returns them
+	void RenderGpu(const FractalParams& params, std::vector<float>& values);
+	// the reference, with each pixel's stability alongside
+	void RenderCpu(const FractalParams& params, std::vector<float>& values, std::vector<uint8_t>& isStable) const;
+
+	bool IsMatch(float gpu, float cpu, int iterations) const;
+	Result Compare(const BenchmarkScene& scene, const std::vector<float>& gpu, const std::vector<float>& cpu, const std::vector<uint8_t>& isStable) const;
+
+	Settings m_Settings;
+	std::vector<Result> m_Results;
+
+	std::unique_ptr<VertexBuffer> m_QuadVertices;
+	std::unique_ptr<IndexBuffer> m_QuadIndices;
+	std::unique_ptr<VertexArray> m_Quad;
+	// fragment shaders built with ITERATION_OUTPUT, in FractalType order
+	std::unique_ptr<Shader> m_Shaders[FRACTAL_MANDELBULB];
+	std::unique_ptr<MultibrotShaders> m_MultibrotShaders;
+	std::unique_ptr<ComputeRenderer> m_ComputeRenderer;
+	std::unique_ptr<Framebuffer> m_Target;
+};
@@ -0,0 +1,124 @@
+#include "SelfCheck.h"
+#include <cpu/EscapeKernels.h>
+#include <cpu/Newton.h>
+#include <renderer/IterationController.h>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+bool SelfCheck::Run()
+{
+	bool isPassed = true;
+	isPassed &= CheckCappedViewHolds();
+	isPassed &= CheckNewtonLanes();
+	isPassed &= CheckTwoProduct();
+	return isPassed;
+}
+
+bool SelfCheck::CheckCappedViewHolds()
+{
+	const int iterations = 1000;
+	const float zoom = 2.0f;
+	const int updates = 4 * IterationController::c_AgreeingSamples + IterationController::c_SettleUpdates;
+
+	// frame times well under the ceiling, so only the stats can lower the cap
+	EscapeStats capped;
+	capped.iterations = iterations;
+	capped.capFraction = 1.0f;
+	capped.nearCapFraction = 0.0f;
+	IterationController controller;
+	int cap = iterations;
+	for (int i = 0; i < updates && cap == iterations; i++) {
+		controller.AddFrameTime(1.0);
+		cap = controller.Update(cap, zoom, capped);
+	}
+	if (cap != iterations) {
+		std::cout << "Self check: an all capped view moved the cap from " << iterations << " to " << cap << std::endl;
+		return false;
+	}
+
+	// the same view with little at the cap should still come down, or the hold proves nothing
+	EscapeStats open = capped;
+	open.capFraction = 0.1f;
+	IterationController lowering;
+	cap = iterations;
+	for (int i = 0; i < updates && cap == iterations; i++) {
+		lowering.AddFrameTime(1.0);
+		cap = lowering.Update(cap, zoom, open);
+	}
+	if (cap >= iterations) {
+		std::cout << "Self check: a view with nothing near the cap did not lower it from " << iterations << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool SelfCheck::CheckNewtonLanes()
+{
+	// z^3 - 1 and z^5 - 2z + 1, over a grid that crosses the basin boundaries;
+	// the odd count leaves a short last packet
+	NewtonPolynomial cubic;
+	NewtonPolynomial quintic;
+	quintic.degree = 5;
+	quintic.coefficients[0] = { 1.0f, 0.0f };
+	quintic.coefficients[1] = { -2.0f, 0.0f };
+	quintic.coefficients[2] = { 0.0f, 0.0f };
+	quintic.coefficients[3] = { 0.0f, 0.0f };
+	quintic.coefficients[4] = { 0.0f, 0.0f };
+	quintic.coefficients[5] = { 1.0f, 0.0f };
+	NewtonPolynomial* polynomials[] = { &cubic, &quintic };
+
+	const int side = 101;
+	const int maxIterations = 64;
+	std::vector<float> zx(side * side);
+	std::vector<float> zy(side * side);
+	for (int i = 0; i < side * side; i++) {
+		zx[i] = -2.0f + 4.0f * (i % side) / (side - 1);
+		zy[i] = -2.0f + 4.0f * (i / side) / (side - 1);
+	}
+
+	bool isPassed = true;
+	for (NewtonPolynomial* polynomial : polynomials) {
+		Newton::FindRoots(*polynomial);
+		std::vector<int> iterations(zx.size());
+		std::vector<int> roots(zx.size());
+		Newton::IterateMany(*polynomial, zx.data(), zy.data(), static_cast<int>(zx.size()), maxIterations, iterations.data(), roots.data());
+
+		int mismatches = 0;
+		for (size_t i = 0; i < zx.size(); i++) {
+			int root;
+			int expected = Newton::Iterate(*polynomial, zx[i], zy[i], maxIterations, root);
+			if (expected != iterations[i] || root != roots[i])
+				mismatches++;
+		}
+		// a contracted multiply-add may send a point on a basin boundary the other way
+		if (mismatches > static_cast<int>(zx.size()) / 1000) {
+			std::cout << "Self check: the Newton lanes differ from the scalar kernel at " << mismatches << " of " << zx.size()
+				<< " points for degree " << polynomial->degree << std::endl;
+			isPassed = false;
+		}
+	}
+	return isPassed;
+}
+
+bool SelfCheck::CheckTwoProduct()
+{
+	// a product of two floats fits a double exactly, so hi + lo must equal it;
+	// full mantissas over a spread of exponents, either sign
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> mantissa(1.0f, 2.0f);
+	std::uniform_int_distribution<int> exponent(-30, 30);
+	for (int i = 0; i < 100000; i++) {
+		float a = std::ldexp(i % 2 ? -mantissa(random) : mantissa(random), exponent(random));
+		float b = std::ldexp(i % 3 ? mantissa(random) : -mantissa(random), exponent(random));
+		float hi, lo;
+		EscapeKernels::TwoProduct(a, b, hi, lo);
+		if (static_cast<double>(hi) + lo != static_cast<double>(a) * b) {
+			std::cout << "Self check: the float-float product of " << a << " and " << b << " is not exact, "
+				<< "is floating point contraction on for EscapeKernels.cpp?" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Checks of CPU code with a known right answer, run by the regression tool
+// before any scene is drawn. Each failure is printed; nothing needs GL.
+class SelfCheck {
+public:
+	// true when every check passes
+	static bool Run();
+
+private:
+	// a view all at the cap, with nothing escaping near it, must not lower the cap
+	static bool CheckCappedViewHolds();
+	// the Float8 Newton kernel must land on the same roots in the same steps as the scalar one,
+	// but for a few points on basin boundaries
+	static bool CheckNewtonLanes();
+	// the float-float product must be exact, which fused multiply-adds break
+	static bool CheckTwoProduct();
+};
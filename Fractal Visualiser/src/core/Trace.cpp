@@ -0,0 +1,228 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "Trace.h"
+#include <core/AllocationCounter.h>
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	struct Span {
+		const char* name;
+		// nanoseconds since the epoch
+		int64_t start;
+		int64_t duration;
+	};
+
+	// a span as it sits in a ring; sequence is the span's index plus one once
+	// it is written, 0 while it is being written
+	struct Slot {
+		std::atomic<uint64_t> sequence{ 0 };
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<int64_t> start{ 0 };
+		std::atomic<int64_t> duration{ 0 };
+	};
+
+	// written only by the thread that holds it, read by Export
+	struct Ring {
+		Slot slots[Trace::c_RingSize];
+		std::atomic<uint64_t> head{ 0 };
+		std::atomic<bool> isHeld{ false };
+		// the id and name the ring's spans are exported under; the name is guarded by s_Mutex
+		int thread = 0;
+		const char* threadName = nullptr;
+	};
+
+	const Trace::Clock::time_point s_Epoch = Trace::Clock::now();
+	std::atomic<bool> s_isRecording{ false };
+
+	// rings are never freed, a thread that exits hands its ring to the next new one;
+	// ring i is thread i + 1, thread 0 is the GPU
+	std::mutex s_Mutex;
+	std::vector<std::unique_ptr<Ring>> s_Rings;
+	std::deque<std::string> s_Names;
+
+	Ring s_GpuRing;
+	int64_t s_GpuOffset = 0;
+
+	// the ring is taken when the thread is named, or else the first time it records
+	struct ThreadRing {
+		Ring* ring = nullptr;
+		const char* name = nullptr;
+		~ThreadRing()
+		{
+			if (ring)
+				ring->isHeld = false;
+		}
+	};
+	thread_local ThreadRing t_Ring;
+
+	Ring& GetThreadRing()
+	{
+		if (t_Ring.ring)
+			return *t_Ring.ring;
+
+		// one-off, and an unnamed thread may first record long after warm-up
+		AllocationCounter::Exempt exempt;
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		for (std::unique_ptr<Ring>& ring : s_Rings) {
+			bool isHeld = false;
+			if (ring->isHeld.compare_exchange_strong(isHeld, true)) {
+				t_Ring.ring = ring.get();
+				break;
+			}
+		}
+
+		if (!t_Ring.ring) {
+			s_Rings.push_back(std::make_unique<Ring>());
+			t_Ring.ring = s_Rings.back().get();
+			t_Ring.ring->thread = static_cast<int>(s_Rings.size());
+			t_Ring.ring->isHeld = true;
+		}
+		t_Ring.ring->threadName = t_Ring.name;
+		return *t_Ring.ring;
+	}
+
+	int64_t ToNanoseconds(Trace::Clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time - s_Epoch).count();
+	}
+
+	void Push(Ring& ring, const Span& span)
+	{
+		// only this thread moves the head, so a relaxed read of it is enough
+		uint64_t head = ring.head.load(std::memory_order_relaxed);
+		Slot& slot = ring.slots[head % Trace::c_RingSize];
+
+		// the slot reads as unwritten before any of its fields change
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(span.name, std::memory_order_relaxed);
+		slot.start.store(span.start, std::memory_order_relaxed);
+		slot.duration.store(span.duration, std::memory_order_relaxed);
+		slot.sequence.store(head + 1, std::memory_order_release);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	void WriteEscaped(FILE* file, const char* text)
+	{
+		for (; *text; text++) {
+			if (*text == '"' || *text == '\\')
+				fputc('\\', file);
+			fputc(static_cast<unsigned char>(*text) < 0x20 ? ' ' : *text, file);
+		}
+	}
+
+	// the span at index, unless the writer has started on that slot again
+	bool ReadSpan(const Ring& ring, uint64_t index, Span& span)
+	{
+		const Slot& slot = ring.slots[index % Trace::c_RingSize];
+		if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+			return false;
+		span.name = slot.name.load(std::memory_order_relaxed);
+		span.start = slot.start.load(std::memory_order_relaxed);
+		span.duration = slot.duration.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+	}
+
+	void WriteRing(FILE* file, const Ring& ring)
+	{
+		// the writer keeps going, so the oldest slots are left to it
+		const uint64_t c_Readable = Trace::c_RingSize - Trace::c_ExportMargin;
+		uint64_t head = ring.head.load(std::memory_order_acquire);
+		uint64_t count = head < c_Readable ? head : c_Readable;
+		for (uint64_t i = head - count; i < head; i++) {
+			Span span;
+			if (!ReadSpan(ring, i, span))
+				continue;
+			fprintf(file, ",\n{\"name\":\"");
+			WriteEscaped(file, span.name);
+			fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", ring.thread, span.start / 1000.0, span.duration / 1000.0);
+		}
+	}
+
+	void WriteThreadName(FILE* file, int thread, const char* name)
+	{
+		fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", thread == 0 ? "" : ",", thread);
+		WriteEscaped(file, name ? name : "Worker");
+		fprintf(file, "\"}}");
+	}
+}
+
+void Trace::SetRecording(bool isRecording)
+{
+	s_isRecording = isRecording;
+}
+
+bool Trace::IsRecording()
+{
+	return s_isRecording.load(std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name)
+{
+	// named threads are the ones that record, so the ring is claimed here at
+	// startup rather than in the first frame after recording is turned on
+	t_Ring.name = name;
+	Ring& ring = GetThreadRing();
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	ring.threadName = name;
+}
+
+const char* Trace::Intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Names.push_back(name);
+	return s_Names.back().c_str();
+}
+
+void Trace::AddSpan(const char* name, Clock::time_point start, Clock::time_point end)
+{
+	if (!IsRecording())
+		return;
+
+	Ring& ring = GetThreadRing();
+	int64_t startNanoseconds = ToNanoseconds(start);
+	Push(ring, { name, startNanoseconds, ToNanoseconds(end) - startNanoseconds });
+}
+
+void Trace::CalibrateGpu(uint64_t gpuNanoseconds, Clock::time_point cpuTime)
+{
+	s_GpuOffset = ToNanoseconds(cpuTime) - static_cast<int64_t>(gpuNanoseconds);
+}
+
+void Trace::AddGpuSpan(const char* name, uint64_t gpuStartNanoseconds, uint64_t durationNanoseconds)
+{
+	if (!IsRecording())
+		return;
+
+	Push(s_GpuRing, { name, static_cast<int64_t>(gpuStartNanoseconds) + s_GpuOffset, static_cast<int64_t>(durationNanoseconds) });
+}
+
+bool Trace::Export(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		WriteThreadName(file, s_GpuRing.thread, "GPU");
+		for (const std::unique_ptr<Ring>& ring : s_Rings)
+			WriteThreadName(file, ring->thread, ring->threadName);
+		for (const std::unique_ptr<Ring>& ring : s_Rings)
+			WriteRing(file, *ring);
+	}
+	WriteRing(file, s_GpuRing);
+	fprintf(file, "\n]}\n");
+
+	return fclose(file) == 0;
+}
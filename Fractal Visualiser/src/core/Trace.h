@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Timeline of named spans, exported as Chrome trace-event JSON for
+// chrome://tracing or Perfetto. Each thread records into a ring of its own, so
+// recording takes no lock: the owning thread writes a span, then publishes it
+// by moving the ring's head. A ring keeps its thread's newest c_RingSize spans,
+// so recording can be left on and a trace saved just after a hitch. Each slot
+// carries the sequence number of the span in it, so an export running beside
+// the writer leaves out the spans it caught half written.
+//
+// A thread that exits hands its ring, and the thread id that goes with it, to
+// the next new thread, so spans the old thread left are shown under the new
+// thread's name.
+//
+// GPU spans from the profiler's timer queries go on a GPU timeline of their
+// own, moved onto the CPU clock with the last CalibrateGpu pair.
+//
+// Span names are not copied and must outlive the trace: string literals, or
+// names from Intern.
+class Trace {
+public:
+	using Clock = std::chrono::steady_clock;
+	static constexpr int c_RingSize = 16384;
+	// oldest slots an export skips, which the writer could reach while it reads
+	static constexpr int c_ExportMargin = 1024;
+
+	static void SetRecording(bool isRecording);
+	static bool IsRecording();
+
+	// names the calling thread in the exported trace
+	static void SetThreadName(const char* name);
+	// a copy of name that lives as long as the program
+	static const char* Intern(const std::string& name);
+
+	static void AddSpan(const char* name, Clock::time_point start, Clock::time_point end);
+
+	// a GL_TIMESTAMP read together with the CPU clock
+	static void CalibrateGpu(uint64_t gpuNanoseconds, Clock::time_point cpuTime);
+	// GPU spans must be added from one thread, the one that owns the context
+	static void AddGpuSpan(const char* name, uint64_t gpuStartNanoseconds, uint64_t durationNanoseconds);
+
+	// spans recorded while this runs may be missing
+	static bool Export(const std::string& path);
+};
+
+// Records the enclosing scope as a span, if the trace was recording when it began.
+class TraceScope {
+public:
+	explicit TraceScope(const char* name) : m_Name(name), m_isActive(Trace::IsRecording())
+	{
+		if (m_isActive)
+			m_Start = Trace::Clock::now();
+	}
+
+	~TraceScope()
+	{
+		if (m_isActive)
+			Trace::AddSpan(m_Name, m_Start, Trace::Clock::now());
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* m_Name;
+	bool m_isActive;
+	Trace::Clock::time_point m_Start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
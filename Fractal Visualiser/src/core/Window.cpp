@@ -3,17 +3,24 @@
 
 GLFWwindow* Window::m_Window = nullptr;
 
-void Window::Init(const char* title, int width, int height)
+void Window::Init(const char* title, int width, int height, bool isVisible)
 {
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	// ask for 4.3 first so the compute backend is available, otherwise settle for 3.3
+	const int versions[2][2] = { {4, 3}, {3, 3} };
+
+	GLFWwindow* window = NULL;
+	for (int i = 0; i < 2 && window == NULL; i++) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versions[i][0]);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versions[i][1]);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, isVisible ? GLFW_TRUE : GLFW_FALSE);
 
 #ifdef __APPLE__
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-	GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, NULL);
+		window = glfwCreateWindow(width, height, title, NULL, NULL);
+	}
 
 	if (window == NULL)
 	{
@@ -25,3 +32,17 @@ void Window::Init(const char* title, int width, int height)
 
 	m_Window = window;
 }
+
+GLFWwindow* Window::CreateSharedContext()
+{
+	// the same version the main context settled on
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glfwGetWindowAttrib(m_Window, GLFW_CONTEXT_VERSION_MAJOR));
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glfwGetWindowAttrib(m_Window, GLFW_CONTEXT_VERSION_MINOR));
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+	return glfwCreateWindow(1, 1, "", NULL, m_Window);
+}
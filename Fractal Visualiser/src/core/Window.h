@@ -8,7 +8,11 @@ private:
 
 public:
 
-    static void Init(const char* title, int width, int height);
+    // a hidden window still gives a context, for running without showing anything
+    static void Init(const char* title, int width, int height, bool isVisible = true);
+    // hidden window whose context shares objects with the main one, for another
+    // thread to make current; must be called on the main thread. Null on failure
+    static GLFWwindow* CreateSharedContext();
 
     inline static GLFWwindow*& GetWindow() { return m_Window; };
 };
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "Buddhabrot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include <core/Trace.h>
+
+namespace {
+	const unsigned int c_Seed = 1234;
+	// small steps are spread over this range of view sizes, mostly towards the small end
+	const double c_SmallStepMin = 1.0e-4;
+	const double c_SmallStepMax = 0.1;
+	// the first batch after a change is short so the image comes back quickly,
+	// and each one after is twice as long up to c_BatchMilliseconds
+	const int c_FirstBatchMilliseconds = 30;
+	// samples between checks of the clock and the generation
+	const int c_CheckInterval = 64;
+	const double c_Pi = 3.14159265358979323846;
+}
+
+struct Buddhabrot::Chain {
+	std::mt19937_64 random;
+	double cx = 0.0;
+	double cy = 0.0;
+	// 0 until the chain has found an orbit that reaches the view
+	int contribution = 0;
+	int escape = 0;
+	std::vector<int> pixels;
+	std::vector<int> proposal;
+};
+
+bool Buddhabrot::Settings::operator==(const Settings& other) const
+{
+	return width == other.width && height == other.height && locationX == other.locationX && locationY == other.locationY
+		&& zoom == other.zoom && std::equal(iterations, iterations + c_NumChannels, other.iterations) && maxSamples == other.maxSamples;
+}
+
+Buddhabrot::Buddhabrot(unsigned int threads)
+{
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	// nothing to sample until the first SetSettings
+	m_isPaused = true;
+	for (unsigned int i = 0; i < threads; i++)
+		m_Workers.emplace_back(&Buddhabrot::Work, this, i);
+}
+
+Buddhabrot::~Buddhabrot()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_isStopping = true;
+		m_Generation++;
+	}
+	m_Wake.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void Buddhabrot::SetSettings(const Settings& settings)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (settings == m_Settings && !m_Total.empty())
+			return;
+
+		m_Settings = settings;
+		m_Total.assign(static_cast<size_t>(settings.width) * settings.height * c_NumChannels, 0.0f);
+		m_Samples = 0;
+		m_Accepted = 0;
+		m_Generation++;
+		m_Revision++;
+	}
+	m_Wake.notify_all();
+}
+
+void Buddhabrot::SetPaused(bool isPaused)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_isPaused == isPaused)
+			return;
+		m_isPaused = isPaused;
+	}
+	m_Wake.notify_all();
+}
+
+bool Buddhabrot::Resolve(uint64_t& revision, std::vector<float>& density)
+{
+	if (m_Revision.load() == revision)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	density = m_Total;
+	revision = m_Revision.load();
+	return true;
+}
+
+double Buddhabrot::GetAcceptance() const
+{
+	uint64_t samples = m_Samples.load(std::memory_order_relaxed);
+	return samples > 0 ? static_cast<double>(m_Accepted.load(std::memory_order_relaxed)) / samples : 0.0;
+}
+
+void Buddhabrot::Work(unsigned int index)
+{
+	Trace::SetThreadName("Buddhabrot");
+
+	Chain chain;
+	chain.random.seed(c_Seed + index);
+	Settings settings;
+	uint64_t generation = 0;
+	int batchMilliseconds = c_FirstBatchMilliseconds;
+	std::vector<float> histogram;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [&]() {
+				return m_isStopping || (!m_isPaused && (m_Generation != generation || m_Samples < m_Settings.maxSamples));
+			});
+			if (m_isStopping)
+				return;
+
+			if (m_Generation != generation) {
+				generation = m_Generation;
+				settings = m_Settings;
+				chain.contribution = 0;
+				batchMilliseconds = c_FirstBatchMilliseconds;
+			}
+		}
+
+		histogram.assign(static_cast<size_t>(settings.width) * settings.height * c_NumChannels, 0.0f);
+		uint64_t samples = 0;
+		uint64_t accepted = 0;
+		auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(batchMilliseconds);
+		batchMilliseconds = std::min(batchMilliseconds * 2, c_BatchMilliseconds);
+
+		{
+			TRACE_SCOPE("Buddhabrot Batch");
+			int maxIterations = *std::max_element(settings.iterations, settings.iterations + c_NumChannels);
+			double smallMin = settings.zoom * c_SmallStepMin;
+			double smallMax = settings.zoom * c_SmallStepMax;
+			std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+			while (samples % c_CheckInterval != 0 || (std::chrono::steady_clock::now() < end && m_Generation == generation)) {
+				// until an orbit reaches the view, every proposal is a fresh point
+				double cx, cy;
+				if (chain.contribution == 0 || unit(chain.random) < c_LargeStepChance) {
+					do {
+						cx = 4.0 * unit(chain.random) - 2.0;
+						cy = 4.0 * unit(chain.random) - 2.0;
+					} while (cx * cx + cy * cy > 4.0);
+				}
+				else {
+					double radius = smallMax * std::exp(-std::log(smallMax / smallMin) * unit(chain.random));
+					double angle = 2.0 * c_Pi * unit(chain.random);
+					cx = chain.cx + radius * std::cos(angle);
+					cy = chain.cy + radius * std::sin(angle);
+				}
+
+				int escape = Iterate(settings, maxIterations, cx, cy, chain.proposal);
+				int contribution = static_cast<int>(chain.proposal.size());
+				samples++;
+
+				// both kinds of step are symmetric, so the acceptance is the ratio of contributions
+				if (contribution > 0 && (chain.contribution == 0 || unit(chain.random) * chain.contribution < contribution)) {
+					chain.pixels.swap(chain.proposal);
+					chain.cx = cx;
+					chain.cy = cy;
+					chain.contribution = contribution;
+					chain.escape = escape;
+					accepted++;
+				}
+
+				// the current state is counted on every step, taken or not
+				if (chain.contribution == 0)
+					continue;
+				float weight = 1.0f / chain.contribution;
+				for (int channel = 0; channel < c_NumChannels; channel++) {
+					if (chain.escape >= settings.iterations[channel])
+						continue;
+					for (int pixel : chain.pixels)
+						histogram[static_cast<size_t>(pixel) * c_NumChannels + channel] += weight;
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (generation != m_Generation)
+			continue;
+		TRACE_SCOPE("Buddhabrot Merge");
+		for (size_t i = 0; i < histogram.size(); i++)
+			m_Total[i] += histogram[i];
+		m_Samples += samples;
+		m_Accepted += accepted;
+		m_Revision++;
+	}
+}
+
+int Buddhabrot::Iterate(const Settings& settings, int maxIterations, double cx, double cy, std::vector<int>& pixels)
+{
+	pixels.clear();
+
+	// the main cardioid and the period 2 bulb never escape
+	double q = (cx - 0.25) * (cx - 0.25) + cy * cy;
+	if (q * (q + cx - 0.25) < 0.25 * cy * cy || (cx + 1.0) * (cx + 1.0) + cy * cy < 0.0625)
+		return maxIterations;
+
+	// the inverse of EscapeTime::MapPixel, with the aspect ratio folded into the scale
+	double scale = settings.height / settings.zoom;
+	double halfWidth = 0.5 * settings.width;
+	double halfHeight = 0.5 * settings.height;
+
+	double zx = 0.0;
+	double zy = 0.0;
+	for (int i = 0; i < maxIterations; i++) {
+		double x = zx * zx - zy * zy + cx;
+		zy = 2.0 * zx * zy + cy;
+		zx = x;
+		if (zx * zx + zy * zy > 4.0)
+			return i;
+
+		double px = (zx - settings.locationX) * scale + halfWidth;
+		double py = (-zy - settings.locationY) * scale + halfHeight;
+		if (px >= 0.0 && px < settings.width && py >= 0.0 && py < settings.height)
+			pixels.push_back(static_cast<int>(py) * settings.width + static_cast<int>(px));
+	}
+
+	pixels.clear();
+	return maxIterations;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Orbit density of the Mandelbrot set's escaping points: every c whose orbit
+// escapes adds one hit to each pixel its z values pass through. Unlike escape
+// time, a pixel's value depends on orbits that start anywhere, so the image is
+// built up by sampling c and splatting whole orbits into a histogram.
+//
+// Each worker thread runs its own Metropolis-Hastings chain over c. The target
+// density is an orbit's contribution, the number of its points that land in
+// the view, so at depth the chains stay among the rare orbits that reach it
+// instead of drawing blind. Proposals are either a small step scaled to the
+// view or, now and then, a fresh point anywhere, so chains do not get stuck in
+// one island. A visited c is splatted with weight 1 / contribution, which
+// takes the sampling bias back out and leaves a fair density.
+//
+// Threads splat into histograms of their own and merge them into the shared
+// total every c_BatchMilliseconds, which is what Resolve hands out. Each
+// colour channel only takes orbits that escape before its own cap; with caps
+// a decade apart that is the Nebulabrot.
+class Buddhabrot {
+public:
+	static constexpr int c_NumChannels = 3;
+	// how often a thread merges its histogram, and so how often the image updates
+	static constexpr int c_BatchMilliseconds = 250;
+	// share of proposals that jump to a new point instead of stepping
+	static constexpr double c_LargeStepChance = 0.2;
+
+	struct Settings {
+		int width = 1280;
+		int height = 720;
+		// mapped as EscapeTime::MapPixel maps the 2D fractals
+		double locationX = 0.0;
+		double locationY = 0.0;
+		double zoom = 2.0;
+		// red, green and blue: an orbit adds to a channel if it escapes before its cap
+		int iterations[c_NumChannels] = { 200, 200, 200 };
+		// the threads go quiet once this many c have been sampled for the view
+		uint64_t maxSamples = 1ull << 26;
+
+		bool operator==(const Settings& other) const;
+	};
+
+	// 0 uses every core but one, which is left for the window
+	explicit Buddhabrot(unsigned int threads = 0);
+	~Buddhabrot();
+
+	// throws away what was sampled if the settings differ from the current ones
+	void SetSettings(const Settings& settings);
+	const Settings& GetSettings() const { return m_Settings; }
+
+	// paused threads sleep until resumed; what was sampled is kept
+	void SetPaused(bool isPaused);
+
+	// copies the merged histogram, width * height * c_NumChannels weights with
+	// the bottom row first, if it changed since revision; revision is updated
+	bool Resolve(uint64_t& revision, std::vector<float>& density);
+
+	// samples taken for the current settings, and the share of proposals taken
+	uint64_t GetSampleCount() const { return m_Samples.load(std::memory_order_relaxed); }
+	double GetAcceptance() const;
+
+private:
+	struct Chain;
+
+	// samples in batches until stopped, merging after each one
+	void Work(unsigned int index);
+
+	// escape count of c, capped at maxIterations, with the pixels of the orbit's
+	// points inside the view in pixels; orbits that never escape leave it empty
+	static int Iterate(const Settings& settings, int maxIterations, double cx, double cy, std::vector<int>& pixels);
+
+	std::vector<std::thread> m_Workers;
+
+	// guards m_Settings, m_Total and the flags the workers wait on
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	Settings m_Settings;
+	std::vector<float> m_Total;
+	bool m_isPaused = false;
+	bool m_isStopping = false;
+
+	// moves whenever the settings change, so a worker can drop a stale batch
+	std::atomic<uint64_t> m_Generation{ 0 };
+	// moves with every merge
+	std::atomic<uint64_t> m_Revision{ 0 };
+	std::atomic<uint64_t> m_Samples{ 0 };
+	std::atomic<uint64_t> m_Accepted{ 0 };
+};
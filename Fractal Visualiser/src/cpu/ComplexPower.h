@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+
+// z^n for the Multibrot and Multicorn. Integer powers are built by repeated
+// squaring, walking n's binary digits from the top: each digit after the first
+// squares the running power and a set digit multiplies z back in, so z^5 is two
+// squarings and one multiply where polar form needs a pow, an atan2, a cos and
+// a sin. The chain is unrolled at compile time for the CPU, and
+// MultibrotShaders writes out the same chain as GLSL.
+class ComplexPower {
+public:
+	// powers up to this many get a chain of their own, above it the polar form is used
+	static constexpr int c_MaxChainPower = 16;
+
+	// z = z^N, for float, double and Float8 alike
+	template<int N, typename T>
+	static void Chain(T& x, T& y)
+	{
+		static_assert(N >= 1, "the chain is for positive powers");
+		Step<N>::Apply(x, y, x, y);
+	}
+
+	// z = z^power in polar form, for any real power; 0 stays at 0
+	template<typename T>
+	static void Polar(T& x, T& y, T power)
+	{
+		T squared = x * x + y * y;
+		if (squared == T(0))
+			return;
+		T radius = std::pow(squared, power * T(0.5));
+		T angle = std::atan2(y, x) * power;
+		x = radius * std::cos(angle);
+		y = radius * std::sin(angle);
+	}
+
+	// n's whole value if it is one with a chain, 0 otherwise
+	static int GetChainPower(float power)
+	{
+		int n = static_cast<int>(power);
+		return n >= 2 && n <= c_MaxChainPower && static_cast<float>(n) == power ? n : 0;
+	}
+
+	// the chain's length, for showing what a power costs
+	static int CountSquarings(int n)
+	{
+		int squarings = 0;
+		for (; n > 1; n >>= 1)
+			squarings++;
+		return squarings;
+	}
+
+	static int CountMultiplies(int n)
+	{
+		int multiplies = -1;
+		for (; n > 0; n >>= 1)
+			multiplies += n & 1;
+		return multiplies;
+	}
+
+private:
+	// (x, y) = (baseX, baseY)^N, built from (baseX, baseY)^(N / 2)
+	template<int N>
+	struct Step {
+		template<typename T>
+		static void Apply(T& x, T& y, T baseX, T baseY)
+		{
+			Step<N / 2>::Apply(x, y, baseX, baseY);
+			T squaredX = x * x - y * y;
+			T squaredY = T(2.0f) * x * y;
+			if (N % 2 == 1) {
+				x = squaredX * baseX - squaredY * baseY;
+				y = squaredX * baseY + squaredY * baseX;
+			}
+			else {
+				x = squaredX;
+				y = squaredY;
+			}
+		}
+	};
+};
+
+template<>
+struct ComplexPower::Step<1> {
+	template<typename T>
+	static void Apply(T& x, T& y, T baseX, T baseY)
+	{
+		x = baseX;
+		y = baseY;
+	}
+};
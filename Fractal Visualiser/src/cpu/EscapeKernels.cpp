@@ -0,0 +1,372 @@
+#include "EscapeKernels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <core/FractalParams.h>
+#include <cpu/EscapeTime.h>
+#include <cpu/Float8.h>
+
+// The float-float kernel's error free transforms need every multiply and add
+// rounded on its own. The project builds this file with /fp:precise, and the
+// pragmas keep contraction off whatever the command line says; a GCC build
+// needs -ffp-contract=off on this file, as GCC fuses by default on targets
+// with FMA. The regression tool's self checks fail if TwoProduct is not exact.
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+// The kernels are templates on the formula so its branches fold away, the way
+// the compute shaders take FRACTAL as a define.
+namespace {
+	const char* c_KernelNames[EscapeKernels::NUM_KERNELS] = { "scalar", "simd", "floatfloat", "fixed", "perturbation" };
+
+	template<int Fractal>
+	void RunScalar(const EscapePoints& points, int begin, int end, int maxIterations, int* counts)
+	{
+		for (int i = begin; i < end; i++)
+			counts[i] = EscapeTime::Count(Fractal, static_cast<float>(points.cx[i]), static_cast<float>(points.cy[i]), 0.0f, 0.0f, maxIterations);
+	}
+
+	template<int Fractal>
+	void RunSimd(const EscapePoints& points, int begin, int end, int maxIterations, int* counts)
+	{
+		const Float8 bailout(EscapeTime::c_Bailout);
+		const Float8 one(1.0f);
+
+		for (int first = begin; first < end; first += Float8::c_Width) {
+			// a short last packet repeats its last point in the spare lanes
+			float cxValues[Float8::c_Width];
+			float cyValues[Float8::c_Width];
+			for (int lane = 0; lane < Float8::c_Width; lane++) {
+				int i = first + lane < end ? first + lane : end - 1;
+				cxValues[lane] = static_cast<float>(points.cx[i]);
+				cyValues[lane] = static_cast<float>(points.cy[i]);
+			}
+
+			Float8 cx = Float8::Load(cxValues);
+			Float8 cy = Float8::Load(cyValues);
+			Float8 zx(0.0f);
+			Float8 zy(0.0f);
+			Float8 isActive = Float8::True();
+			Float8 count(0.0f);
+
+			for (int iteration = 0; iteration < maxIterations; iteration++) {
+				Float8 x, y;
+				if (Fractal == FRACTAL_BURNINGSHIP) {
+					x = zx * zx - zy * zy;
+					y = Float8(2.0f) * Abs(zx) * Abs(zy);
+				}
+				else {
+					if (Fractal == FRACTAL_TRICORN)
+						zy = -zy;
+					x = zx * zx - zy * zy;
+					y = Float8(2.0f) * zx * zy;
+				}
+				zx = x + cx;
+				zy = y + cy;
+
+				// escaped lanes run on and overflow, but they never count again
+				isActive = isActive & (zx * zx + zy * zy <= bailout);
+				if (!Any(isActive))
+					break;
+				count += isActive & one;
+			}
+
+			float countValues[Float8::c_Width];
+			count.Store(countValues);
+			for (int lane = 0; lane < Float8::c_Width && first + lane < end; lane++)
+				counts[first + lane] = static_cast<int>(countValues[lane]);
+		}
+	}
+
+	// Dekker's error free transforms, with contraction off above
+	struct FloatFloat {
+		float hi;
+		float lo;
+	};
+
+	FloatFloat TwoSum(float a, float b)
+	{
+		float sum = a + b;
+		float bPart = sum - a;
+		return { sum, (a - (sum - bPart)) + (b - bPart) };
+	}
+
+	FloatFloat QuickTwoSum(float a, float b)
+	{
+		float sum = a + b;
+		return { sum, b - (sum - a) };
+	}
+
+	FloatFloat TwoProduct(float a, float b)
+	{
+		// splits a float into two halves of 12 bits whose products are exact
+		const float split = 4097.0f;
+		float product = a * b;
+		float aScaled = split * a;
+		float aHi = aScaled - (aScaled - a);
+		float aLo = a - aHi;
+		float bScaled = split * b;
+		float bHi = bScaled - (bScaled - b);
+		float bLo = b - bHi;
+		return { product, ((aHi * bHi - product) + aHi * bLo + aLo * bHi) + aLo * bLo };
+	}
+
+	FloatFloat operator+(FloatFloat a, FloatFloat b)
+	{
+		FloatFloat sum = TwoSum(a.hi, b.hi);
+		return QuickTwoSum(sum.hi, sum.lo + a.lo + b.lo);
+	}
+
+	FloatFloat operator-(FloatFloat a)
+	{
+		return { -a.hi, -a.lo };
+	}
+
+	FloatFloat operator-(FloatFloat a, FloatFloat b)
+	{
+		return a + -b;
+	}
+
+	FloatFloat operator*(FloatFloat a, FloatFloat b)
+	{
+		FloatFloat product = TwoProduct(a.hi, b.hi);
+		return QuickTwoSum(product.hi, product.lo + a.hi * b.lo + a.lo * b.hi);
+	}
+
+	FloatFloat ToFloatFloat(double value)
+	{
+		float hi = static_cast<float>(value);
+		return { hi, static_cast<float>(value - hi) };
+	}
+
+	FloatFloat Abs(FloatFloat a)
+	{
+		return a.hi < 0.0f ? -a : a;
+	}
+
+	template<int Fractal>
+	void RunFloatFloat(const EscapePoints& points, int begin, int end, int maxIterations, int* counts)
+	{
+		const FloatFloat two = { 2.0f, 0.0f };
+
+		for (int i = begin; i < end; i++) {
+			FloatFloat cx = ToFloatFloat(points.cx[i]);
+			FloatFloat cy = ToFloatFloat(points.cy[i]);
+			FloatFloat zx = { 0.0f, 0.0f };
+			FloatFloat zy = { 0.0f, 0.0f };
+
+			int iters = 0;
+			for (; iters < maxIterations; ++iters) {
+				FloatFloat x, y;
+				if (Fractal == FRACTAL_BURNINGSHIP) {
+					x = zx * zx - zy * zy;
+					y = two * Abs(zx) * Abs(zy);
+				}
+				else {
+					if (Fractal == FRACTAL_TRICORN)
+						zy = -zy;
+					x = zx * zx - zy * zy;
+					y = two * zx * zy;
+				}
+				zx = x + cx;
+				zy = y + cy;
+
+				// the low parts can not move the sum past the bailout by more than rounding
+				if (zx.hi * zx.hi + zy.hi * zy.hi > EscapeTime::c_Bailout)
+					break;
+			}
+			counts[i] = iters;
+		}
+	}
+
+	template<int Fractal>
+	void RunFixed(const EscapePoints& points, int begin, int end, int maxIterations, int* counts)
+	{
+		const int bits = EscapeKernels::c_FixedBits;
+		const double scale = static_cast<double>(int64_t(1) << bits);
+		// compared against squares, which carry twice the fractional bits
+		const int64_t bailout = static_cast<int64_t>(EscapeTime::c_Bailout) << (2 * bits);
+
+		for (int i = begin; i < end; i++) {
+			int64_t cx = static_cast<int64_t>(std::llround(points.cx[i] * scale));
+			int64_t cy = static_cast<int64_t>(std::llround(points.cy[i] * scale));
+			int64_t zx = 0;
+			int64_t zy = 0;
+
+			int iters = 0;
+			for (; iters < maxIterations; ++iters) {
+				int64_t ax = zx;
+				int64_t ay = zy;
+				if (Fractal == FRACTAL_BURNINGSHIP) {
+					ax = ax < 0 ? -ax : ax;
+					ay = ay < 0 ? -ay : ay;
+				}
+				else if (Fractal == FRACTAL_TRICORN) {
+					ay = -ay;
+				}
+				int64_t x = (zx * zx - zy * zy) >> bits;
+				int64_t y = (ax * ay) >> (bits - 1);
+				zx = x + cx;
+				zy = y + cy;
+
+				if (zx * zx + zy * zy > bailout)
+					break;
+			}
+			counts[i] = iters;
+		}
+	}
+
+	// |c + d| - |c| without the cancellation of working it out directly
+	float DiffAbs(float c, float d)
+	{
+		if (c >= 0.0f)
+			return c + d >= 0.0f ? d : -(2.0f * c + d);
+		return c + d > 0.0f ? 2.0f * c + d : -d;
+	}
+
+	template<int Fractal>
+	void RunPerturbation(const EscapePoints& points, const ReferenceOrbit& reference, int begin, int end, int maxIterations, int* counts)
+	{
+		const float* referenceX = reference.zx.data();
+		const float* referenceY = reference.zy.data();
+		int last = static_cast<int>(reference.zx.size()) - 1;
+
+		for (int i = begin; i < end; i++) {
+			float dcx = static_cast<float>(points.cx[i] - reference.cx);
+			float dcy = static_cast<float>(points.cy[i] - reference.cy);
+			float dx = 0.0f;
+			float dy = 0.0f;
+			int n = 0;
+
+			int iters = 0;
+			for (; iters < maxIterations; ++iters) {
+				float rx = referenceX[n];
+				float ry = referenceY[n];
+
+				// the offset's next value, from f(Z + d) - f(Z)
+				float nx, ny;
+				if (Fractal == FRACTAL_BURNINGSHIP) {
+					float ax = DiffAbs(rx, dx);
+					float ay = DiffAbs(ry, dy);
+					nx = 2.0f * (rx * dx - ry * dy) + dx * dx - dy * dy;
+					ny = 2.0f * (std::fabs(rx) * ay + ax * std::fabs(ry) + ax * ay);
+				}
+				else {
+					nx = 2.0f * (rx * dx - ry * dy) + dx * dx - dy * dy;
+					ny = 2.0f * (rx * dy + ry * dx + dx * dy);
+					// conj(Z + d)^2 - conj(Z)^2 is the conjugate of the mandelbrot step
+					if (Fractal == FRACTAL_TRICORN)
+						ny = -ny;
+				}
+				dx = nx + dcx;
+				dy = ny + dcy;
+				n++;
+
+				float zx = referenceX[n] + dx;
+				float zy = referenceY[n] + dy;
+				float magnitude = zx * zx + zy * zy;
+				if (magnitude > EscapeTime::c_Bailout)
+					break;
+
+				// once z is nearer the orbit's start than the offset is to the
+				// orbit, or the orbit ran out, carry on from its start instead
+				if (magnitude < dx * dx + dy * dy || n == last) {
+					dx = zx;
+					dy = zy;
+					n = 0;
+				}
+			}
+			counts[i] = iters;
+		}
+	}
+
+	template<int Fractal>
+	void RunKernel(EscapeKernels::Kernel kernel, const EscapePoints& points, const ReferenceOrbit& reference,
+		int begin, int end, int maxIterations, int* counts)
+	{
+		switch (kernel) {
+		case EscapeKernels::KERNEL_SIMD:
+			RunSimd<Fractal>(points, begin, end, maxIterations, counts);
+			break;
+		case EscapeKernels::KERNEL_FLOATFLOAT:
+			RunFloatFloat<Fractal>(points, begin, end, maxIterations, counts);
+			break;
+		case EscapeKernels::KERNEL_FIXED:
+			RunFixed<Fractal>(points, begin, end, maxIterations, counts);
+			break;
+		case EscapeKernels::KERNEL_PERTURBATION:
+			RunPerturbation<Fractal>(points, reference, begin, end, maxIterations, counts);
+			break;
+		default:
+			RunScalar<Fractal>(points, begin, end, maxIterations, counts);
+			break;
+		}
+	}
+}
+
+const char* EscapeKernels::GetName(Kernel kernel)
+{
+	return kernel >= 0 && kernel < NUM_KERNELS ? c_KernelNames[kernel] : "unknown";
+}
+
+void EscapeKernels::Run(Kernel kernel, int fractal, const EscapePoints& points, const ReferenceOrbit& reference,
+	int begin, int end, int maxIterations, int* counts)
+{
+	switch (fractal) {
+	case FRACTAL_BURNINGSHIP:
+		RunKernel<FRACTAL_BURNINGSHIP>(kernel, points, reference, begin, end, maxIterations, counts);
+		break;
+	case FRACTAL_TRICORN:
+		RunKernel<FRACTAL_TRICORN>(kernel, points, reference, begin, end, maxIterations, counts);
+		break;
+	default:
+		RunKernel<FRACTAL_MANDELBROT>(kernel, points, reference, begin, end, maxIterations, counts);
+		break;
+	}
+}
+
+void EscapeKernels::TwoProduct(float a, float b, float& hi, float& lo)
+{
+	FloatFloat product = ::TwoProduct(a, b);
+	hi = product.hi;
+	lo = product.lo;
+}
+
+ReferenceOrbit EscapeKernels::ComputeReference(int fractal, double cx, double cy, int maxIterations)
+{
+	ReferenceOrbit reference;
+	reference.cx = cx;
+	reference.cy = cy;
+	reference.zx.reserve(maxIterations + 1);
+	reference.zy.reserve(maxIterations + 1);
+
+	double zx = 0.0;
+	double zy = 0.0;
+	reference.zx.push_back(0.0f);
+	reference.zy.push_back(0.0f);
+
+	for (int i = 0; i < maxIterations; i++) {
+		double x, y;
+		if (fractal == FRACTAL_BURNINGSHIP) {
+			x = zx * zx - zy * zy;
+			y = 2.0 * std::fabs(zx) * std::fabs(zy);
+		}
+		else {
+			if (fractal == FRACTAL_TRICORN)
+				zy = -zy;
+			x = zx * zx - zy * zy;
+			y = 2.0 * zx * zy;
+		}
+		zx = x + cx;
+		zy = y + cy;
+
+		reference.zx.push_back(static_cast<float>(zx));
+		reference.zy.push_back(static_cast<float>(zy));
+		if (zx * zx + zy * zy > EscapeTime::c_Bailout)
+			break;
+	}
+	return reference;
+}
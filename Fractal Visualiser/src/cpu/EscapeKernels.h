@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+// Points to iterate, as c values with z starting at 0 the way the 2D fractals
+// do outside Julia mode. Kept in double so the kernels with more precision than
+// float get the points exactly.
+struct EscapePoints {
+	std::vector<double> cx;
+	std::vector<double> cy;
+
+	int GetCount() const { return static_cast<int>(cx.size()); }
+};
+
+// Orbit of one point in double, stored in float, that the perturbation kernel
+// iterates the other points' offsets against.
+struct ReferenceOrbit {
+	double cx = 0.0;
+	double cy = 0.0;
+	// z at each iteration, starting with z0 = 0; ends at the cap or the first z past the bailout
+	std::vector<float> zx;
+	std::vector<float> zy;
+};
+
+// Escape time kernels for the 2D fractals, in the number formats and
+// strategies worth comparing on the CPU. Each fills in the same escape counts
+// EscapeTime::Count gives, give or take the rounding of its own format:
+//   scalar        float, one point at a time, as EscapeTime
+//   simd          float, Float8 lanes, a lane stops counting once it escapes
+//   floatfloat    an unevaluated sum of two floats, about 48 bits of mantissa
+//   fixed         64 bit integers with c_FixedBits fractional bits
+//   perturbation  float offsets from a double reference orbit, rebased to the
+//                 start of the orbit when the offset outgrows the orbit
+class EscapeKernels {
+public:
+	enum Kernel {
+		KERNEL_SCALAR = 0,
+		KERNEL_SIMD,
+		KERNEL_FLOATFLOAT,
+		KERNEL_FIXED,
+		KERNEL_PERTURBATION,
+		NUM_KERNELS
+	};
+
+	// the largest z component before the bailout check is under 8, so its
+	// square still fits in 64 bits at this scale
+	static constexpr int c_FixedBits = 27;
+
+	static const char* GetName(Kernel kernel);
+
+	// escape counts of points [begin, end) into counts[begin, end); the
+	// reference is only read by the perturbation kernel
+	static void Run(Kernel kernel, int fractal, const EscapePoints& points, const ReferenceOrbit& reference,
+		int begin, int end, int maxIterations, int* counts);
+
+	static ReferenceOrbit ComputeReference(int fractal, double cx, double cy, int maxIterations);
+
+	// a * b as hi + lo exactly, as the floatfloat kernel multiplies; it is
+	// only exact while the compiler leaves the multiplies and adds unfused
+	static void TwoProduct(float a, float b, float& hi, float& lo);
+};
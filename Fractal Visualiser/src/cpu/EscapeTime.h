@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cmath>
+#include <core/FractalParams.h>
+#include <cpu/ComplexPower.h>
+
+// Scalar escape time for the 2D fractals, iterating exactly as the shaders do,
+// for tools that need to know how much work a view is without reading it back
+// from the GPU, and as the reference the GPU output is checked against.
+// The Multibrot and Multicorn take power as well, and run on kernels templated
+// on it as the shader variants are compiled for it.
+class EscapeTime {
+public:
+	static constexpr float c_Bailout = 4.0f;
+
+	// iterations run before z escaped, at most maxIterations; z is left where it stopped
+	static int Iterate(int fractal, float cx, float cy, float& zx, float& zy, int maxIterations, float power = 2.0f)
+	{
+		if (fractal == FRACTAL_MULTICORN)
+			return MultiDispatch<true, ComplexPower::c_MaxChainPower>::Run(ComplexPower::GetChainPower(power), power, cx, cy, zx, zy, maxIterations);
+		if (fractal == FRACTAL_MULTIBROT)
+			return MultiDispatch<false, ComplexPower::c_MaxChainPower>::Run(ComplexPower::GetChainPower(power), power, cx, cy, zx, zy, maxIterations);
+
+		int iters = 0;
+		for (; iters < maxIterations; ++iters) {
+			float x, y;
+			if (fractal == FRACTAL_BURNINGSHIP) {
+				float ax = zx < 0.0f ? -zx : zx;
+				float ay = zy < 0.0f ? -zy : zy;
+				x = zx * zx - zy * zy;
+				y = 2.0f * ax * ay;
+			}
+			else {
+				// the tricorn conjugates z first
+				if (fractal == FRACTAL_TRICORN)
+					zy = -zy;
+				x = zx * zx - zy * zy;
+				y = 2.0f * zx * zy;
+			}
+			zx = x + cx;
+			zy = y + cy;
+			if (zx * zx + zy * zy > c_Bailout)
+				break;
+		}
+		return iters;
+	}
+
+	static int Count(int fractal, float cx, float cy, float zx, float zy, int maxIterations, float power = 2.0f)
+	{
+		return Iterate(fractal, cx, cy, zx, zy, maxIterations, power);
+	}
+
+	// the Multibrot, or with IsConjugate the Multicorn, at a power fixed at compile time
+	template<int Power, bool IsConjugate>
+	static int IterateChain(float cx, float cy, float& zx, float& zy, int maxIterations)
+	{
+		int iters = 0;
+		for (; iters < maxIterations; ++iters) {
+			if (IsConjugate)
+				zy = -zy;
+			ComplexPower::Chain<Power>(zx, zy);
+			zx += cx;
+			zy += cy;
+			if (zx * zx + zy * zy > c_Bailout)
+				break;
+		}
+		return iters;
+	}
+
+	// the same for powers without a chain, several times slower
+	template<bool IsConjugate>
+	static int IteratePolar(float power, float cx, float cy, float& zx, float& zy, int maxIterations)
+	{
+		int iters = 0;
+		for (; iters < maxIterations; ++iters) {
+			if (IsConjugate)
+				zy = -zy;
+			ComplexPower::Polar(zx, zy, power);
+			zx += cx;
+			zy += cy;
+			if (zx * zx + zy * zy > c_Bailout)
+				break;
+		}
+		return iters;
+	}
+
+	// iterations for the pixel at (px, py), mapped as MapPixel does
+	static int CountPixel(const FractalParams& params, int px, int py)
+	{
+		float zx, zy;
+		float cx, cy;
+		MapPixel(params, px, py, cx, cy, zx, zy);
+		return Iterate(params.fractal, cx, cy, zx, zy, params.iterations, params.power);
+	}
+
+	// the shaders' smooth iteration count; a z that hit the cap comes out at
+	// maxIterations or more, or as NaN, much as it does on the GPU
+	static float SmoothCount(int fractal, float cx, float cy, float zx, float zy, int maxIterations, float power = 2.0f)
+	{
+		int iters = Iterate(fractal, cx, cy, zx, zy, maxIterations, power);
+		float degree = fractal == FRACTAL_MULTIBROT || fractal == FRACTAL_MULTICORN ? power : 2.0f;
+		return iters - std::log(std::log(zx * zx + zy * zy) / std::log(c_Bailout)) / std::log(degree);
+	}
+
+	// the c and starting z the shaders iterate for the pixel whose bottom left
+	// corner is (px, py), sampled at its centre as gl_FragCoord is
+	static void MapPixel(const FractalParams& params, int px, int py, float& cx, float& cy, float& zx, float& zy)
+	{
+		float ratio = static_cast<float>(params.width) / params.height;
+		float x = ((px + 0.5f) / params.width * ratio - ratio / 2.0f) * params.zoom + params.location.x;
+		float y = -(((py + 0.5f) / params.height - 0.5f) * params.zoom + params.location.y);
+
+		if (params.juliaMode) {
+			cx = params.juliaConstant.x;
+			cy = params.juliaConstant.y;
+			zx = x;
+			zy = y;
+		}
+		else {
+			cx = x;
+			cy = y;
+			zx = 0.0f;
+			zy = 0.0f;
+		}
+	}
+
+private:
+	// picks the chain for power chainPower, counting down from N; 0 falls through to polar form
+	template<bool IsConjugate, int N>
+	struct MultiDispatch {
+		static int Run(int chainPower, float power, float cx, float cy, float& zx, float& zy, int maxIterations)
+		{
+			if (chainPower == N)
+				return IterateChain<N, IsConjugate>(cx, cy, zx, zy, maxIterations);
+			return MultiDispatch<IsConjugate, N - 1>::Run(chainPower, power, cx, cy, zx, zy, maxIterations);
+		}
+	};
+
+	template<bool IsConjugate>
+	struct MultiDispatch<IsConjugate, 1> {
+		static int Run(int, float power, float cx, float cy, float& zx, float& zy, int maxIterations)
+		{
+			return IteratePolar<IsConjugate>(power, cx, cy, zx, zy, maxIterations);
+		}
+	};
+};
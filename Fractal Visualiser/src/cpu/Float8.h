@@ -0,0 +1,84 @@
+#pragma once
+
+#include <emmintrin.h>
+
+// Eight floats processed together, held as two SSE registers so it builds for
+// every target the project has. Comparisons return masks with every bit of a
+// lane set or clear, for Select, Any and All. Functions with no SSE form, like
+// the trig in the fractional power bulb, go through Map one lane at a time.
+class Float8 {
+public:
+	static constexpr int c_Width = 8;
+
+	Float8() = default;
+	Float8(float value) : m_Lo(_mm_set1_ps(value)), m_Hi(_mm_set1_ps(value)) {}
+	Float8(__m128 lo, __m128 hi) : m_Lo(lo), m_Hi(hi) {}
+
+	// mask with every lane set
+	static Float8 True()
+	{
+		__m128 ones = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		return { ones, ones };
+	}
+
+	static Float8 Load(const float* values) { return { _mm_loadu_ps(values), _mm_loadu_ps(values + 4) }; }
+	void Store(float* values) const { _mm_storeu_ps(values, m_Lo); _mm_storeu_ps(values + 4, m_Hi); }
+
+	float operator[](int lane) const
+	{
+		float values[c_Width];
+		Store(values);
+		return values[lane];
+	}
+
+	template<typename F>
+	Float8 Map(F function) const
+	{
+		float values[c_Width];
+		Store(values);
+		for (float& value : values)
+			value = function(value);
+		return Load(values);
+	}
+
+	friend Float8 operator+(Float8 a, Float8 b) { return { _mm_add_ps(a.m_Lo, b.m_Lo), _mm_add_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator-(Float8 a, Float8 b) { return { _mm_sub_ps(a.m_Lo, b.m_Lo), _mm_sub_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator*(Float8 a, Float8 b) { return { _mm_mul_ps(a.m_Lo, b.m_Lo), _mm_mul_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator/(Float8 a, Float8 b) { return { _mm_div_ps(a.m_Lo, b.m_Lo), _mm_div_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator-(Float8 a) { return Float8(0.0f) - a; }
+
+	Float8& operator+=(Float8 b) { return *this = *this + b; }
+	Float8& operator-=(Float8 b) { return *this = *this - b; }
+	Float8& operator*=(Float8 b) { return *this = *this * b; }
+
+	friend Float8 operator<(Float8 a, Float8 b) { return { _mm_cmplt_ps(a.m_Lo, b.m_Lo), _mm_cmplt_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator<=(Float8 a, Float8 b) { return { _mm_cmple_ps(a.m_Lo, b.m_Lo), _mm_cmple_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator>(Float8 a, Float8 b) { return b < a; }
+	friend Float8 operator>=(Float8 a, Float8 b) { return b <= a; }
+	friend Float8 operator==(Float8 a, Float8 b) { return { _mm_cmpeq_ps(a.m_Lo, b.m_Lo), _mm_cmpeq_ps(a.m_Hi, b.m_Hi) }; }
+
+	// masks
+	friend Float8 operator&(Float8 a, Float8 b) { return { _mm_and_ps(a.m_Lo, b.m_Lo), _mm_and_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 operator|(Float8 a, Float8 b) { return { _mm_or_ps(a.m_Lo, b.m_Lo), _mm_or_ps(a.m_Hi, b.m_Hi) }; }
+	// a and not b
+	friend Float8 AndNot(Float8 a, Float8 b) { return { _mm_andnot_ps(b.m_Lo, a.m_Lo), _mm_andnot_ps(b.m_Hi, a.m_Hi) }; }
+
+	// one bit per lane, lane 0 lowest
+	friend int MoveMask(Float8 mask) { return _mm_movemask_ps(mask.m_Lo) | (_mm_movemask_ps(mask.m_Hi) << 4); }
+	friend bool Any(Float8 mask) { return MoveMask(mask) != 0; }
+	friend bool All(Float8 mask) { return MoveMask(mask) == 0xFF; }
+
+	// a where the mask is set, b elsewhere
+	friend Float8 Select(Float8 mask, Float8 a, Float8 b) { return (mask & a) | AndNot(b, mask); }
+
+	friend Float8 Min(Float8 a, Float8 b) { return { _mm_min_ps(a.m_Lo, b.m_Lo), _mm_min_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 Max(Float8 a, Float8 b) { return { _mm_max_ps(a.m_Lo, b.m_Lo), _mm_max_ps(a.m_Hi, b.m_Hi) }; }
+	friend Float8 Clamp(Float8 a, Float8 lo, Float8 hi) { return Min(Max(a, lo), hi); }
+	// clears the sign bit
+	friend Float8 Abs(Float8 a) { return AndNot(a, Float8(-0.0f)); }
+	friend Float8 Sqrt(Float8 a) { return { _mm_sqrt_ps(a.m_Lo), _mm_sqrt_ps(a.m_Hi) }; }
+
+private:
+	__m128 m_Lo;
+	__m128 m_Hi;
+};
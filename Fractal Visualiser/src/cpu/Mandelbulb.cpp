@@ -0,0 +1,332 @@
+#include "Mandelbulb.h"
+#include <algorithm>
+#include <cmath>
+
+float Mandelbulb::Distance(float x, float y, float z, float power, int iterations)
+{
+	float length = std::sqrt(x * x + y * y + z * z);
+	if (length > c_BoundRadius)
+		return length - 1.2f;
+
+	float cx = x, cy = y, cz = z;
+	float dr = 1.0f;
+	float r = 0.0f;
+	for (int i = 0; i < iterations; i++) {
+		// to polar
+		r = std::sqrt(x * x + y * y + z * z);
+		if (r > 2.0f)
+			break;
+		float theta = std::acos(z / r);
+		float phi = std::atan2(y, x);
+
+		dr = std::pow(r, power - 1.0f) * power * dr + 1.0f;
+
+		// scale and rotate, back to cartesian
+		float zr = std::pow(r, power);
+		theta *= power;
+		phi *= power;
+
+		x = zr * std::sin(theta) * std::cos(phi) + cx;
+		y = zr * std::sin(phi) * std::sin(theta) + cy;
+		z = zr * std::cos(theta) + cz;
+	}
+
+	return 0.5f * std::log(r) * r / dr;
+}
+
+static Float8 Log(Float8 a)
+{
+	return a.Map([](float value) { return std::log(value); });
+}
+
+Float8 Mandelbulb::Distance(Float8 x, Float8 y, Float8 z, float power, int iterations)
+{
+	Float8 length = Sqrt(x * x + y * y + z * z);
+	Float8 outside = length > c_BoundRadius;
+	if (All(outside))
+		return length - 1.2f;
+
+	Float8 distance;
+	if (power == 8.0f) {
+		distance = DistancePower8(x, y, z, iterations);
+	}
+	else if (power == std::floor(power) && power >= 2.0f) {
+		distance = DistanceInteger(x, y, z, static_cast<int>(power), iterations);
+	}
+	else {
+		float px[Float8::c_Width], py[Float8::c_Width], pz[Float8::c_Width], d[Float8::c_Width];
+		x.Store(px);
+		y.Store(py);
+		z.Store(pz);
+		for (int lane = 0; lane < Float8::c_Width; lane++)
+			d[lane] = Distance(px[lane], py[lane], pz[lane], power, iterations);
+		return Float8::Load(d);
+	}
+
+	return Select(outside, length - 1.2f, distance);
+}
+
+// mandelbulbPower8 in the shader, escaped lanes keep their last z and dr
+Float8 Mandelbulb::DistancePower8(Float8 x, Float8 y, Float8 z, int iterations)
+{
+	Float8 cx = x, cy = y, cz = z;
+	Float8 dr = 1.0f;
+	Float8 r = 0.0f;
+	Float8 active = Float8::True();
+
+	for (int i = 0; i < iterations; i++) {
+		Float8 r2 = x * x + y * y + z * z;
+		r = Sqrt(r2);
+		active = AndNot(active, r > 2.0f);
+		if (!Any(active))
+			break;
+
+		Float8 rho2 = x * x + y * y;
+
+		// (z + i rho)^8 and (x + i y)^8 by squaring three times
+		Float8 tre = z, tim = Sqrt(rho2);
+		Float8 pre = x, pim = y;
+		for (int k = 0; k < 3; k++) {
+			Float8 temp = tre * tre - tim * tim;
+			tim = 2.0f * tre * tim;
+			tre = temp;
+			temp = pre * pre - pim * pim;
+			pim = 2.0f * pre * pim;
+			pre = temp;
+		}
+
+		Float8 rho8 = rho2 * rho2;
+		rho8 *= rho8;
+		Float8 onAxis = rho8 <= 0.0f;
+		Float8 scale = 1.0f / Select(onAxis, 1.0f, rho8);
+		pre = Select(onAxis, 1.0f, pre * scale);
+		pim = Select(onAxis, 0.0f, pim * scale);
+
+		Float8 r6 = r2 * r2 * r2;
+		dr = Select(active, 8.0f * r6 * r * dr + 1.0f, dr);
+
+		x = Select(active, tim * pre + cx, x);
+		y = Select(active, tim * pim + cy, y);
+		z = Select(active, tre + cz, z);
+	}
+
+	return 0.5f * Log(r) * r / dr;
+}
+
+// mandelbulbInteger in the shader
+Float8 Mandelbulb::DistanceInteger(Float8 x, Float8 y, Float8 z, int power, int iterations)
+{
+	Float8 cx = x, cy = y, cz = z;
+	Float8 dr = 1.0f;
+	Float8 r = 0.0f;
+	Float8 active = Float8::True();
+
+	for (int i = 0; i < iterations; i++) {
+		r = Sqrt(x * x + y * y + z * z);
+		active = AndNot(active, r > 2.0f);
+		if (!Any(active))
+			break;
+
+		Float8 tare = z, taim = Sqrt(x * x + y * y);
+		Float8 pare = x, paim = y;
+		Float8 tre = 1.0f, tim = 0.0f;
+		Float8 pre = 1.0f, pim = 0.0f;
+		for (int k = power; k > 0; k >>= 1) {
+			if (k & 1) {
+				Float8 temp = tre * tare - tim * taim;
+				tim = tre * taim + tim * tare;
+				tre = temp;
+				temp = pre * pare - pim * paim;
+				pim = pre * paim + pim * pare;
+				pre = temp;
+			}
+			Float8 temp = tare * tare - taim * taim;
+			taim = 2.0f * tare * taim;
+			tare = temp;
+			temp = pare * pare - paim * paim;
+			paim = 2.0f * pare * paim;
+			pare = temp;
+		}
+
+		Float8 rn = Sqrt(tre * tre + tim * tim);
+		Float8 rhoN = Sqrt(pre * pre + pim * pim);
+		Float8 onAxis = rhoN <= 0.0f;
+		Float8 scale = 1.0f / Select(onAxis, 1.0f, rhoN);
+		pre = Select(onAxis, 1.0f, pre * scale);
+		pim = Select(onAxis, 0.0f, pim * scale);
+
+		dr = Select(active, static_cast<float>(power) * rn / r * dr + 1.0f, dr);
+
+		x = Select(active, tim * pre + cx, x);
+		y = Select(active, tim * pim + cy, y);
+		z = Select(active, tre + cz, z);
+	}
+
+	return 0.5f * Log(r) * r / dr;
+}
+
+// Dual numbers as in the shader's normals: v is the value and d its gradient
+// with respect to the sample position.
+template<typename T>
+struct Dual {
+	T v, dx, dy, dz;
+};
+
+template<typename T> static Dual<T> operator+(const Dual<T>& a, const Dual<T>& b) { return { a.v + b.v, a.dx + b.dx, a.dy + b.dy, a.dz + b.dz }; }
+template<typename T> static Dual<T> operator-(const Dual<T>& a, const Dual<T>& b) { return { a.v - b.v, a.dx - b.dx, a.dy - b.dy, a.dz - b.dz }; }
+template<typename T> static Dual<T> operator*(T s, const Dual<T>& a) { return { s * a.v, s * a.dx, s * a.dy, s * a.dz }; }
+
+template<typename T>
+static Dual<T> operator*(const Dual<T>& a, const Dual<T>& b)
+{
+	return { a.v * b.v, a.v * b.dx + b.v * a.dx, a.v * b.dy + b.v * a.dy, a.v * b.dz + b.v * a.dz };
+}
+
+template<typename T>
+static Dual<T> operator/(const Dual<T>& a, const Dual<T>& b)
+{
+	T inv = T(1.0f) / (b.v * b.v);
+	return { a.v / b.v, (a.dx * b.v - a.v * b.dx) * inv, (a.dy * b.v - a.v * b.dy) * inv, (a.dz * b.v - a.v * b.dz) * inv };
+}
+
+// a scaled by f(a.v), with derivative scale g
+template<typename T>
+static Dual<T> Chain(const Dual<T>& a, T f, T g)
+{
+	return { f, g * a.dx, g * a.dy, g * a.dz };
+}
+
+static float Sqrt(float a) { return std::sqrt(a); }
+
+template<typename T>
+static Dual<T> DualSqrt(const Dual<T>& a)
+{
+	T s = Sqrt(a.v);
+	return Chain(a, s, T(0.5f) / s);
+}
+
+template<typename T>
+static void DualSquare(Dual<T>& re, Dual<T>& im)
+{
+	Dual<T> temp = re * re - im * im;
+	im = T(2.0f) * (re * im);
+	re = temp;
+}
+
+// the escaped orbit's radius grows fastest straight out of the surface
+template<typename T>
+static void OrbitGradient(const Dual<T>& x, const Dual<T>& y, const Dual<T>& z, T& nx, T& ny, T& nz)
+{
+	nx = x.v * x.dx + y.v * y.dx + z.v * z.dx;
+	ny = x.v * x.dy + y.v * y.dy + z.v * z.dy;
+	nz = x.v * x.dz + y.v * y.dz + z.v * z.dz;
+	T scale = T(1.0f) / Sqrt(nx * nx + ny * ny + nz * nz);
+	nx = nx * scale;
+	ny = ny * scale;
+	nz = nz * scale;
+}
+
+// NormalTrig in the shader, one point at a time
+static void NormalTrig(float px, float py, float pz, float power, int iterations, float& nx, float& ny, float& nz)
+{
+	Dual<float> x = { px, 1.0f, 0.0f, 0.0f };
+	Dual<float> y = { py, 0.0f, 1.0f, 0.0f };
+	Dual<float> z = { pz, 0.0f, 0.0f, 1.0f };
+	Dual<float> cx = x, cy = y, cz = z;
+
+	for (int i = 0; i < iterations; i++) {
+		Dual<float> r = DualSqrt(x * x + y * y + z * z);
+		if (r.v > 2.0f)
+			break;
+
+		Dual<float> cosTheta = z / r;
+		Dual<float> theta = Chain(cosTheta, std::acos(cosTheta.v), -1.0f / std::sqrt(std::max(1.0f - cosTheta.v * cosTheta.v, 1e-12f)));
+		float atanScale = 1.0f / (x.v * x.v + y.v * y.v);
+		Dual<float> phi = { std::atan2(y.v, x.v), (x.v * y.dx - y.v * x.dx) * atanScale, (x.v * y.dy - y.v * x.dy) * atanScale, (x.v * y.dz - y.v * x.dz) * atanScale };
+		theta = power * theta;
+		phi = power * phi;
+
+		float rPow = std::pow(r.v, power - 1.0f);
+		Dual<float> zr = Chain(r, rPow * r.v, power * rPow);
+
+		Dual<float> sinTheta = Chain(theta, std::sin(theta.v), std::cos(theta.v));
+		Dual<float> cosPhi = Chain(phi, std::cos(phi.v), -std::sin(phi.v));
+		Dual<float> sinPhi = Chain(phi, std::sin(phi.v), std::cos(phi.v));
+		Dual<float> cosThetaN = Chain(theta, std::cos(theta.v), -std::sin(theta.v));
+
+		x = zr * (sinTheta * cosPhi) + cx;
+		y = zr * (sinPhi * sinTheta) + cy;
+		z = zr * cosThetaN + cz;
+	}
+
+	OrbitGradient(x, y, z, nx, ny, nz);
+}
+
+// NormalPower8 in the shader, all eight lanes together
+static void NormalPower8(Float8 px, Float8 py, Float8 pz, int iterations, Float8& nx, Float8& ny, Float8& nz)
+{
+	Dual<Float8> x = { px, 1.0f, 0.0f, 0.0f };
+	Dual<Float8> y = { py, 0.0f, 1.0f, 0.0f };
+	Dual<Float8> z = { pz, 0.0f, 0.0f, 1.0f };
+	Dual<Float8> cx = x, cy = y, cz = z;
+	Float8 active = Float8::True();
+
+	auto select = [](Float8 mask, const Dual<Float8>& a, const Dual<Float8>& b) -> Dual<Float8> {
+		return { Select(mask, a.v, b.v), Select(mask, a.dx, b.dx), Select(mask, a.dy, b.dy), Select(mask, a.dz, b.dz) };
+	};
+
+	for (int i = 0; i < iterations; i++) {
+		active = AndNot(active, x.v * x.v + y.v * y.v + z.v * z.v > 4.0f);
+		if (!Any(active))
+			break;
+
+		Dual<Float8> rho2 = x * x + y * y;
+
+		Dual<Float8> tre = z, tim = DualSqrt(rho2);
+		Dual<Float8> pre = x, pim = y;
+		for (int k = 0; k < 3; k++) {
+			DualSquare(tre, tim);
+			DualSquare(pre, pim);
+		}
+
+		Dual<Float8> rho8 = rho2 * rho2;
+		rho8 = rho8 * rho8;
+		Float8 onAxis = rho8.v <= 0.0f;
+		Dual<Float8> safe = select(onAxis, { 1.0f, 0.0f, 0.0f, 0.0f }, rho8);
+		pre = select(onAxis, { 1.0f, 0.0f, 0.0f, 0.0f }, pre / safe);
+		pim = select(onAxis, { 0.0f, 0.0f, 0.0f, 0.0f }, pim / safe);
+
+		x = select(active, tim * pre + cx, x);
+		y = select(active, tim * pim + cy, y);
+		z = select(active, tre + cz, z);
+	}
+
+	OrbitGradient(x, y, z, nx, ny, nz);
+}
+
+void Mandelbulb::Normal(Float8 x, Float8 y, Float8 z, float power, int iterations, Float8& nx, Float8& ny, Float8& nz)
+{
+	if (power == 8.0f) {
+		NormalPower8(x, y, z, iterations, nx, ny, nz);
+	}
+	else {
+		float px[Float8::c_Width], py[Float8::c_Width], pz[Float8::c_Width];
+		float rx[Float8::c_Width], ry[Float8::c_Width], rz[Float8::c_Width];
+		x.Store(px);
+		y.Store(py);
+		z.Store(pz);
+		for (int lane = 0; lane < Float8::c_Width; lane++)
+			NormalTrig(px[lane], py[lane], pz[lane], power, iterations, rx[lane], ry[lane], rz[lane]);
+		nx = Float8::Load(rx);
+		ny = Float8::Load(ry);
+		nz = Float8::Load(rz);
+	}
+
+	// outside the bound the estimate is a sphere
+	Float8 length = Sqrt(x * x + y * y + z * z);
+	Float8 outside = length > c_BoundRadius;
+	Float8 scale = 1.0f / length;
+	nx = Select(outside, x * scale, nx);
+	ny = Select(outside, y * scale, ny);
+	nz = Select(outside, z * scale, nz);
+}
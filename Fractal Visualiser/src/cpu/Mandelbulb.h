@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cpu/Float8.h>
+
+// CPU copy of the distance estimator in mandelbulb.shader, for work done off the
+// GPU. Keep the two in step.
+class Mandelbulb
+{
+public:
+	// everything outside this radius is empty, matches BOUND_RADIUS in the shader
+	static constexpr float c_BoundRadius = 1.4f;
+
+	static float Distance(float x, float y, float z, float power, int iterations);
+
+	// eight points at once, taking the same power 8 and whole power shortcuts
+	// as the shader. Lanes stop iterating as they escape.
+	static Float8 Distance(Float8 x, Float8 y, Float8 z, float power, int iterations);
+
+	// unit surface normals as in GetNormal, the gradient of the final orbit radius
+	static void Normal(Float8 x, Float8 y, Float8 z, float power, int iterations, Float8& nx, Float8& ny, Float8& nz);
+
+private:
+	static Float8 DistancePower8(Float8 x, Float8 y, Float8 z, int iterations);
+	static Float8 DistanceInteger(Float8 x, Float8 y, Float8 z, int power, int iterations);
+};
@@ -0,0 +1,209 @@
+#include "MandelbulbRenderer.h"
+#include <cpu/Float8.h>
+#include <cpu/Mandelbulb.h>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+// same as the defines in mandelbulb.shader
+static constexpr int c_MaxSteps = 100;
+static constexpr int c_MaxShadowSteps = 64;
+static constexpr float c_MaxDist = 100.0f;
+static constexpr float c_MinSurfaceDist = 0.0005f;
+static constexpr float c_OverRelax = 1.6f;
+
+namespace {
+
+struct Vec8 {
+	Float8 x, y, z;
+};
+
+Float8 Dot(const Vec8& a, const Vec8& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Vec8 Along(const Vec8& ro, const Vec8& rd, Float8 t)
+{
+	return { ro.x + rd.x * t, ro.y + rd.y * t, ro.z + rd.z * t };
+}
+
+Vec8 Normalize(const Vec8& a)
+{
+	Float8 scale = 1.0f / Sqrt(Dot(a, a));
+	return { a.x * scale, a.y * scale, a.z * scale };
+}
+
+// BoundingSphere in the shader, enter > leave when the ray misses
+void BoundingSphere(const Vec8& ro, const Vec8& rd, Float8& enter, Float8& leave)
+{
+	float radius = Mandelbulb::c_BoundRadius;
+	Float8 b = Dot(ro, rd);
+	Float8 h = b * b - (Dot(ro, ro) - radius * radius);
+	Float8 miss = h < 0.0f;
+	h = Sqrt(Max(h, 0.0f));
+	enter = Select(miss, 1.0f, Max(-b - h, 0.0f));
+	leave = Select(miss, -1.0f, -b + h);
+}
+
+}
+
+MandelbulbRenderer::MandelbulbRenderer(const Settings& settings) : m_Settings(settings)
+{
+	// camera() in the shader, orbiting the origin at distance 3
+	m_CameraPos[0] = std::sin(m_Settings.angle) * 3.0f;
+	m_CameraPos[1] = 0.0f;
+	m_CameraPos[2] = std::cos(m_Settings.angle) * 3.0f;
+
+	float cd[3] = { -m_CameraPos[0] / 3.0f, 0.0f, -m_CameraPos[2] / 3.0f };
+	// cross((0, 1, 0), cd), already unit length since cd is level
+	float cr[3] = { cd[2], 0.0f, -cd[0] };
+	float cu[3] = { cd[1] * cr[2] - cd[2] * cr[1], cd[2] * cr[0] - cd[0] * cr[2], cd[0] * cr[1] - cd[1] * cr[0] };
+
+	for (int i = 0; i < 3; i++) {
+		m_Right[i] = -cr[i];
+		m_Up[i] = cu[i];
+		m_Forward[i] = cd[i];
+	}
+}
+
+std::vector<uint8_t> MandelbulbRenderer::Render() const
+{
+	std::vector<uint8_t> pixels(static_cast<size_t>(m_Settings.width) * m_Settings.height * 3);
+
+	int tilesX = (m_Settings.width + c_TileSize - 1) / c_TileSize;
+	int tilesY = (m_Settings.height + c_TileSize - 1) / c_TileSize;
+	int numTiles = tilesX * tilesY;
+	std::atomic<int> nextTile{ 0 };
+
+	auto work = [&]() {
+		for (int tile = nextTile++; tile < numTiles; tile = nextTile++)
+			RenderTile(tile % tilesX, tile / tilesX, pixels.data());
+	};
+
+	unsigned int numThreads = m_Settings.threads ? m_Settings.threads : std::thread::hardware_concurrency();
+	std::vector<std::thread> helpers;
+	for (unsigned int i = 1; i < numThreads; i++)
+		helpers.emplace_back(work);
+	work();
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	return pixels;
+}
+
+void MandelbulbRenderer::RenderTile(int tileX, int tileY, uint8_t* pixels) const
+{
+	const float power = m_Settings.power;
+	const int iterations = m_Settings.iterations;
+	const float width = static_cast<float>(m_Settings.width);
+	const float height = static_cast<float>(m_Settings.height);
+
+	auto distance = [&](const Vec8& p) {
+		return Mandelbulb::Distance(p.x, p.y, p.z, power, iterations);
+	};
+	auto pixelEpsilon = [&](Float8 t) {
+		return Max(c_MinSurfaceDist, 0.5f * t / height);
+	};
+
+	// pixel offsets of the lanes within a packet
+	float laneX[Float8::c_Width], laneY[Float8::c_Width];
+	for (int lane = 0; lane < Float8::c_Width; lane++) {
+		laneX[lane] = static_cast<float>(lane % c_PacketWidth);
+		laneY[lane] = static_cast<float>(lane / c_PacketWidth);
+	}
+
+	Vec8 ro = { m_CameraPos[0], m_CameraPos[1], m_CameraPos[2] };
+
+	for (int py = tileY * c_TileSize; py < (tileY + 1) * c_TileSize && py < m_Settings.height; py += c_PacketHeight) {
+		for (int px = tileX * c_TileSize; px < (tileX + 1) * c_TileSize && px < m_Settings.width; px += c_PacketWidth) {
+			// gl_FragCoord at the pixel centres
+			Float8 fragX = Float8::Load(laneX) + (px + 0.5f);
+			Float8 fragY = Float8::Load(laneY) + (py + 0.5f);
+			Float8 u = (fragX - 0.5f * width) / height;
+			Float8 v = (fragY - 0.5f * height) / height;
+
+			Vec8 rd = Normalize({
+				m_Right[0] * u + m_Up[0] * v + m_Forward[0],
+				m_Right[1] * u + m_Up[1] * v + m_Forward[1],
+				m_Right[2] * u + m_Up[2] * v + m_Forward[2]
+			});
+
+			// RayMarch: each lane is done once it hits, leaves the bound or
+			// runs out of steps, and keeps its result while the others go on
+			Float8 t, leave;
+			BoundingSphere(ro, rd, t, leave);
+			Float8 done = t > leave;
+			Float8 result = c_MaxDist;
+			Float8 omega = c_OverRelax;
+			Float8 stepLength = 0.0f;
+			Float8 prevRadius = 0.0f;
+
+			for (int step = 0; step < c_MaxSteps && !All(done); step++) {
+				Float8 radius = distance(Along(ro, rd, t));
+
+				Float8 relaxFailed = (omega > 1.0f) & (radius + prevRadius < stepLength);
+				stepLength = Select(relaxFailed, stepLength - omega * stepLength, radius * omega);
+				omega = Select(relaxFailed, 1.0f, omega);
+				prevRadius = Select(done, prevRadius, radius);
+
+				Float8 hit = AndNot(AndNot(radius < pixelEpsilon(t), relaxFailed), done);
+				result = Select(hit, t, result);
+				done = done | hit | (t > leave);
+				t = Select(done, t, t + stepLength);
+			}
+
+			// out of steps, a hit only if it got close
+			Float8 close = AndNot(prevRadius < 10.0f * pixelEpsilon(t), done);
+			result = Select(close, t, result);
+
+			Float8 hit = result < c_MaxDist;
+			Float8 color = 0.0f;
+			if (Any(hit)) {
+				Vec8 p = Along(ro, rd, result);
+				Vec8 n;
+				Mandelbulb::Normal(p.x, p.y, p.z, power, iterations, n.x, n.y, n.z);
+				Float8 eps = pixelEpsilon(result);
+
+				// CalculateDiffuseLighting
+				Vec8 toLight = { 0.0f - p.x, 2.0f - p.y, -4.0f - p.z };
+				Vec8 l = Normalize(toLight);
+				Float8 diffuse = Clamp(Dot(n, l), 0.0f, 1.0f);
+
+				// shadow() with k = 2, lanes that missed start finished
+				Vec8 so = Along(p, n, 2.0f * eps);
+				Float8 shadowStart, shadowEnd;
+				BoundingSphere(so, l, shadowStart, shadowEnd);
+				Float8 shade = 1.0f;
+				Float8 st = 0.0f;
+				Float8 lit = hit;
+				for (int step = 0; step < c_MaxShadowSteps; step++) {
+					lit = lit & (st < shadowEnd);
+					if (!Any(lit))
+						break;
+
+					Float8 h = distance(Along(so, l, st));
+					Float8 blocked = lit & (h < 0.001f);
+					shade = Select(blocked, 0.0f, Select(lit, Min(shade, 2.0f * h / st), shade));
+					lit = AndNot(lit, blocked);
+					st = Select(lit, st + h, st);
+				}
+
+				color = Select(hit, diffuse * shade, 0.0f);
+			}
+
+			float values[Float8::c_Width];
+			Clamp(color, 0.0f, 1.0f).Store(values);
+			for (int lane = 0; lane < Float8::c_Width; lane++) {
+				int x = px + lane % c_PacketWidth;
+				int y = py + lane / c_PacketWidth;
+				if (x >= m_Settings.width || y >= m_Settings.height)
+					continue;
+
+				uint8_t value = static_cast<uint8_t>(values[lane] * 255.0f + 0.5f);
+				uint8_t* pixel = pixels + (static_cast<size_t>(y) * m_Settings.width + x) * 3;
+				pixel[0] = pixel[1] = pixel[2] = value;
+			}
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Renders the Mandelbulb on the CPU, for machines without a usable GPU. It is
+// the plain image of mandelbulb.shader: the same camera, over-relaxed march,
+// analytic normals, soft shadow and diffuse light, without the pre-passes or
+// accumulation. Rays go through in packets of Float8::c_Width, a 4x2 block of
+// pixels, and lanes drop out of the march as they hit or leave the bound while
+// the rest carry on. Threads take 16x16 tiles from a shared counter, the same
+// way the compute backend's workgroups do.
+class MandelbulbRenderer {
+public:
+	struct Settings {
+		int width = 1280;
+		int height = 720;
+		// orbit angle of the camera, the x of location in the app
+		float angle = 0.0f;
+		float power = 8.0f;
+		int iterations = 20;
+		// 0 uses every core
+		unsigned int threads = 0;
+	};
+
+	static constexpr int c_TileSize = 16;
+	static constexpr int c_PacketWidth = 4;
+	static constexpr int c_PacketHeight = 2;
+
+	MandelbulbRenderer(const Settings& settings);
+
+	// RGB, 8 bits a channel, bottom row first like glReadPixels
+	std::vector<uint8_t> Render() const;
+
+private:
+	void RenderTile(int tileX, int tileY, uint8_t* pixels) const;
+
+	Settings m_Settings;
+	float m_CameraPos[3];
+	// columns of the shader's camera matrix
+	float m_Right[3];
+	float m_Up[3];
+	float m_Forward[3];
+};
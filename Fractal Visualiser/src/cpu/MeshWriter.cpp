@@ -0,0 +1,141 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "MeshWriter.h"
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// wide enough for any count, PLY readers parse the leading zeros fine
+static constexpr int c_CountDigits = 12;
+static constexpr size_t c_FaceChunk = 4096;
+
+bool MeshWriter::FormatFromPath(const std::string& path, Format& format)
+{
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+		return false;
+
+	std::string extension = path.substr(dot + 1);
+	for (char& c : extension)
+		c = static_cast<char>(tolower(c));
+
+	if (extension == "stl") {
+		format = Format::STL;
+		return true;
+	}
+	if (extension == "ply") {
+		format = Format::PLY;
+		return true;
+	}
+	return false;
+}
+
+MeshWriter::MeshWriter(const std::string& path, Format format) : m_Format(format)
+{
+	m_File = fopen(path.c_str(), "wb");
+	if (m_File)
+		WriteHeader();
+}
+
+MeshWriter::~MeshWriter()
+{
+	Close();
+}
+
+void MeshWriter::WriteHeader()
+{
+	if (m_Format == Format::STL) {
+		char header[80] = "Mandelbulb - Fractal Visualiser";
+		uint32_t count = 0;
+		fwrite(header, 1, sizeof(header), m_File);
+		m_FaceCountOffset = ftell(m_File);
+		fwrite(&count, sizeof(count), 1, m_File);
+		return;
+	}
+
+	fprintf(m_File, "ply\nformat binary_little_endian 1.0\nelement vertex ");
+	m_VertexCountOffset = ftell(m_File);
+	fprintf(m_File, "%0*d\nproperty float x\nproperty float y\nproperty float z\nelement face ", c_CountDigits, 0);
+	m_FaceCountOffset = ftell(m_File);
+	fprintf(m_File, "%0*d\nproperty list uchar uint vertex_indices\nend_header\n", c_CountDigits, 0);
+}
+
+void MeshWriter::Write(const float* triangles, size_t count)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_File)
+		return;
+
+	if (m_Format == Format::PLY) {
+		// every triangle gets its own three vertices, the faces are written by Close
+		fwrite(triangles, sizeof(float), count * 9, m_File);
+	}
+	else {
+		for (size_t i = 0; i < count; i++) {
+			const float* t = triangles + i * 9;
+			float u[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+			float v[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+			float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length > 0.0f) {
+				n[0] /= length;
+				n[1] /= length;
+				n[2] /= length;
+			}
+
+			uint16_t attributes = 0;
+			fwrite(n, sizeof(float), 3, m_File);
+			fwrite(t, sizeof(float), 9, m_File);
+			fwrite(&attributes, sizeof(attributes), 1, m_File);
+		}
+	}
+	m_TriangleCount += count;
+}
+
+void MeshWriter::Close()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_File)
+		return;
+
+	if (m_Format == Format::PLY) {
+		#pragma pack(push, 1)
+		struct Face {
+			uint8_t count;
+			uint32_t indices[3];
+		};
+		#pragma pack(pop)
+
+		std::vector<Face> faces(c_FaceChunk);
+		for (size_t first = 0; first < m_TriangleCount; first += c_FaceChunk) {
+			size_t n = m_TriangleCount - first < c_FaceChunk ? m_TriangleCount - first : c_FaceChunk;
+			for (size_t i = 0; i < n; i++) {
+				uint32_t vertex = static_cast<uint32_t>((first + i) * 3);
+				faces[i] = { 3, { vertex, vertex + 1, vertex + 2 } };
+			}
+			fwrite(faces.data(), sizeof(Face), n, m_File);
+		}
+	}
+
+	PatchCounts();
+	fclose(m_File);
+	m_File = nullptr;
+}
+
+void MeshWriter::PatchCounts()
+{
+	if (m_Format == Format::STL) {
+		uint32_t count = static_cast<uint32_t>(m_TriangleCount);
+		fseek(m_File, m_FaceCountOffset, SEEK_SET);
+		fwrite(&count, sizeof(count), 1, m_File);
+		return;
+	}
+
+	fseek(m_File, m_VertexCountOffset, SEEK_SET);
+	fprintf(m_File, "%0*zu", c_CountDigits, m_TriangleCount * 3);
+	fseek(m_File, m_FaceCountOffset, SEEK_SET);
+	fprintf(m_File, "%0*zu", c_CountDigits, m_TriangleCount);
+}
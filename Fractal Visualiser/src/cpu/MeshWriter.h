@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+// Streams triangles straight to a binary STL or PLY file, so a mesh never has
+// to fit in memory. Counts are left as placeholders in the header and patched
+// in by Close.
+class MeshWriter {
+public:
+	enum class Format { STL, PLY };
+
+	// picks the format from the file extension, false if it is neither
+	static bool FormatFromPath(const std::string& path, Format& format);
+
+	MeshWriter(const std::string& path, Format format);
+	~MeshWriter();
+
+	bool IsOpen() const { return m_File != nullptr; }
+
+	// triangles are 9 floats each, three corners counter-clockwise seen from
+	// outside. Safe to call from several threads.
+	void Write(const float* triangles, size_t count);
+	void Close();
+
+	size_t GetTriangleCount() const { return m_TriangleCount; }
+
+private:
+	void WriteHeader();
+	void PatchCounts();
+
+	FILE* m_File = nullptr;
+	Format m_Format;
+	size_t m_TriangleCount = 0;
+	std::mutex m_Mutex;
+
+	// where the placeholder counts sit in the header
+	long m_VertexCountOffset = 0;
+	long m_FaceCountOffset = 0;
+};
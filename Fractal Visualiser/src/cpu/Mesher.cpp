@@ -0,0 +1,213 @@
+#include "Mesher.h"
+#include <cpu/Mandelbulb.h>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+// triangles a thread collects before handing them to the writer
+static constexpr size_t c_FlushTriangles = 1 << 14;
+
+// the cube split into six tetrahedra around the 0-7 diagonal, corners are
+// numbered x + 2y + 4z. Every cube splits its faces the same way, so
+// neighbouring cubes always agree on the shared triangles.
+static constexpr int c_Tetrahedra[6][4] = {
+	{ 0, 1, 3, 7 }, { 0, 3, 2, 7 }, { 0, 2, 6, 7 }, { 0, 6, 4, 7 }, { 0, 4, 5, 7 }, { 0, 5, 1, 7 }
+};
+
+Mesher::Mesher(const Settings& settings) : m_Settings(settings)
+{
+	m_LeafDepth = 0;
+	while ((1 << m_LeafDepth) < m_Settings.resolution)
+		m_LeafDepth++;
+
+	int brickDepth = 0;
+	while ((1 << brickDepth) < c_BrickSize)
+		brickDepth++;
+	m_BrickDepth = m_LeafDepth > brickDepth ? m_LeafDepth - brickDepth : 0;
+	m_TaskDepth = m_BrickDepth < 3 ? m_BrickDepth : 3;
+
+	m_LeafSize = 2.0f * Mandelbulb::c_BoundRadius / (1 << m_LeafDepth);
+	// the estimate never quite reaches zero, so the surface sits a leaf out,
+	// the same way the ray marcher stops a pixel out
+	m_IsoLevel = m_LeafSize;
+}
+
+float Mesher::Field(float x, float y, float z) const
+{
+	return Mandelbulb::Distance(x, y, z, m_Settings.power, m_Settings.iterations) - m_IsoLevel;
+}
+
+size_t Mesher::Run(MeshWriter& writer)
+{
+	int tasksPerSide = 1 << m_TaskDepth;
+	int numTasks = tasksPerSide * tasksPerSide * tasksPerSide;
+	std::atomic<int> nextTask{ 0 };
+	std::atomic<int> tasksDone{ 0 };
+
+	auto work = [&]() {
+		Scratch scratch;
+		scratch.samples.resize((c_BrickSize + 1) * (c_BrickSize + 1) * (c_BrickSize + 1));
+		scratch.triangles.reserve(c_FlushTriangles * 9 + 2 * 9);
+
+		for (int task = nextTask++; task < numTasks; task = nextTask++) {
+			int x = task % tasksPerSide;
+			int y = (task / tasksPerSide) % tasksPerSide;
+			int z = task / (tasksPerSide * tasksPerSide);
+			Refine(m_TaskDepth, x, y, z, scratch, writer);
+
+			int done = ++tasksDone;
+			if (done % tasksPerSide == 0)
+				std::cout << "\rMeshing: " << done * 100 / numTasks << "%" << std::flush;
+		}
+
+		if (!scratch.triangles.empty())
+			writer.Write(scratch.triangles.data(), scratch.triangles.size() / 9);
+	};
+
+	unsigned int numThreads = m_Settings.threads ? m_Settings.threads : std::thread::hardware_concurrency();
+	std::vector<std::thread> helpers;
+	for (unsigned int i = 1; i < numThreads; i++)
+		helpers.emplace_back(work);
+	work();
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	std::cout << std::endl;
+	return writer.GetTriangleCount();
+}
+
+void Mesher::Refine(int depth, int x, int y, int z, Scratch& scratch, MeshWriter& writer) const
+{
+	float size = 2.0f * Mandelbulb::c_BoundRadius / (1 << depth);
+	float cx = (x + 0.5f) * size - Mandelbulb::c_BoundRadius;
+	float cy = (y + 0.5f) * size - Mandelbulb::c_BoundRadius;
+	float cz = (z + 0.5f) * size - Mandelbulb::c_BoundRadius;
+
+	// the surface cannot be closer than the estimate, so a cell whose corners
+	// are all nearer the centre than that is empty
+	if (Field(cx, cy, cz) > 0.5f * size * 1.7321f)
+		return;
+
+	if (depth == m_BrickDepth) {
+		PolygoniseBrick(x, y, z, scratch, writer);
+		return;
+	}
+
+	for (int child = 0; child < 8; child++)
+		Refine(depth + 1, 2 * x + (child & 1), 2 * y + ((child >> 1) & 1), 2 * z + ((child >> 2) & 1), scratch, writer);
+}
+
+void Mesher::PolygoniseBrick(int x, int y, int z, Scratch& scratch, MeshWriter& writer) const
+{
+	int cells = 1 << (m_LeafDepth - m_BrickDepth);
+	int points = cells + 1;
+
+	float origin[3] = {
+		x * cells * m_LeafSize - Mandelbulb::c_BoundRadius,
+		y * cells * m_LeafSize - Mandelbulb::c_BoundRadius,
+		z * cells * m_LeafSize - Mandelbulb::c_BoundRadius
+	};
+
+	float* samples = scratch.samples.data();
+	for (int k = 0; k < points; k++)
+		for (int j = 0; j < points; j++)
+			for (int i = 0; i < points; i++)
+				samples[(k * points + j) * points + i] = Field(origin[0] + i * m_LeafSize, origin[1] + j * m_LeafSize, origin[2] + k * m_LeafSize);
+
+	float positions[8][3];
+	const float* corners[4];
+	float values[8];
+	float tetValues[4];
+
+	for (int k = 0; k < cells; k++) {
+		for (int j = 0; j < cells; j++) {
+			for (int i = 0; i < cells; i++) {
+				int inside = 0;
+				for (int c = 0; c < 8; c++) {
+					int ci = i + (c & 1), cj = j + ((c >> 1) & 1), ck = k + ((c >> 2) & 1);
+					values[c] = samples[(ck * points + cj) * points + ci];
+					positions[c][0] = origin[0] + ci * m_LeafSize;
+					positions[c][1] = origin[1] + cj * m_LeafSize;
+					positions[c][2] = origin[2] + ck * m_LeafSize;
+					inside += values[c] < 0.0f;
+				}
+				if (inside == 0 || inside == 8)
+					continue;
+
+				for (const int* tet : c_Tetrahedra) {
+					for (int v = 0; v < 4; v++) {
+						corners[v] = positions[tet[v]];
+						tetValues[v] = values[tet[v]];
+					}
+					PolygoniseTetrahedron(corners, tetValues, scratch);
+				}
+			}
+		}
+	}
+
+	if (scratch.triangles.size() >= c_FlushTriangles * 9) {
+		writer.Write(scratch.triangles.data(), scratch.triangles.size() / 9);
+		scratch.triangles.clear();
+	}
+}
+
+void Mesher::PolygoniseTetrahedron(const float* corners[4], const float values[4], Scratch& scratch) const
+{
+	int inside[4], outside[4];
+	int numInside = 0, numOutside = 0;
+	for (int v = 0; v < 4; v++) {
+		if (values[v] < 0.0f)
+			inside[numInside++] = v;
+		else
+			outside[numOutside++] = v;
+	}
+	if (numInside == 0 || numOutside == 0)
+		return;
+
+	// where the field crosses zero along the edge from a to b
+	auto crossing = [&](int a, int b, float* out) {
+		float t = values[a] / (values[a] - values[b]);
+		for (int c = 0; c < 3; c++)
+			out[c] = corners[a][c] + t * (corners[b][c] - corners[a][c]);
+	};
+
+	// facing out means facing from the inside corners to the outside ones
+	float outward[3] = { 0.0f, 0.0f, 0.0f };
+	for (int c = 0; c < 3; c++) {
+		for (int v = 0; v < numOutside; v++)
+			outward[c] += corners[outside[v]][c] / numOutside;
+		for (int v = 0; v < numInside; v++)
+			outward[c] -= corners[inside[v]][c] / numInside;
+	}
+
+	auto emit = [&](const float* a, const float* b, const float* c) {
+		float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+		if (n[0] * outward[0] + n[1] * outward[1] + n[2] * outward[2] < 0.0f)
+			std::swap(b, c);
+
+		scratch.triangles.insert(scratch.triangles.end(), a, a + 3);
+		scratch.triangles.insert(scratch.triangles.end(), b, b + 3);
+		scratch.triangles.insert(scratch.triangles.end(), c, c + 3);
+	};
+
+	float p[4][3];
+	if (numInside == 1 || numOutside == 1) {
+		// one corner cut off: a single triangle
+		int lone = numInside == 1 ? inside[0] : outside[0];
+		const int* others = numInside == 1 ? outside : inside;
+		for (int v = 0; v < 3; v++)
+			crossing(lone, others[v], p[v]);
+		emit(p[0], p[1], p[2]);
+		return;
+	}
+
+	// two and two: a quad across the four edges between the pairs
+	crossing(inside[0], outside[0], p[0]);
+	crossing(inside[0], outside[1], p[1]);
+	crossing(inside[1], outside[1], p[2]);
+	crossing(inside[1], outside[0], p[3]);
+	emit(p[0], p[1], p[2]);
+	emit(p[0], p[2], p[3]);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cpu/MeshWriter.h>
+
+// Polygonises the Mandelbulb on a virtual resolution^3 grid over its bounding
+// cube without ever holding that grid. An octree is walked depth first and a
+// cell is only split while the distance estimate says the surface could pass
+// through it. Cells that survive down to brick size are sampled densely and
+// run through marching tetrahedra, and the triangles are streamed to the
+// writer in small batches. Threads take top level cells from a shared counter.
+class Mesher {
+public:
+	struct Settings {
+		float power = 8.0f;
+		int iterations = 20;
+		// cells per side, rounded up to a power of two
+		int resolution = 2048;
+		// 0 uses every core
+		unsigned int threads = 0;
+	};
+
+	// leaf cells per side of a densely sampled brick
+	static constexpr int c_BrickSize = 8;
+	// largest resolution, already far past what a mesh file can hold
+	static constexpr int c_MaxResolution = 1 << 16;
+
+	Mesher(const Settings& settings);
+
+	// returns the number of triangles written
+	size_t Run(MeshWriter& writer);
+
+private:
+	struct Scratch {
+		std::vector<float> samples;
+		std::vector<float> triangles;
+	};
+
+	float Field(float x, float y, float z) const;
+	void Refine(int depth, int x, int y, int z, Scratch& scratch, MeshWriter& writer) const;
+	void PolygoniseBrick(int x, int y, int z, Scratch& scratch, MeshWriter& writer) const;
+	void PolygoniseTetrahedron(const float* corners[4], const float values[4], Scratch& scratch) const;
+
+	Settings m_Settings;
+	int m_LeafDepth;
+	int m_BrickDepth;
+	int m_TaskDepth;
+	float m_LeafSize;
+	float m_IsoLevel;
+};
@@ -0,0 +1,146 @@
+#include "Newton.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cpu/Float8.h>
+
+namespace {
+	// roots that move less than this in a step are done
+	const double c_RootPrecision = 1.0e-12;
+}
+
+void Newton::FindRoots(NewtonPolynomial& polynomial)
+{
+	int degree = polynomial.degree;
+	while (degree > 0 && polynomial.coefficients[degree].x == 0.0f && polynomial.coefficients[degree].y == 0.0f)
+		degree--;
+
+	polynomial.rootCount = degree;
+	if (degree == 0)
+		return;
+
+	// Durand-Kerner on the monic polynomial: every root estimate steps by
+	// p(r) over its distance to all the others, all at once
+	std::complex<double> coefficients[NewtonPolynomial::c_MaxDegree + 1];
+	std::complex<double> leading(polynomial.coefficients[degree].x, polynomial.coefficients[degree].y);
+	for (int i = 0; i <= degree; i++)
+		coefficients[i] = std::complex<double>(polynomial.coefficients[i].x, polynomial.coefficients[i].y) / leading;
+
+	// the usual start: powers of a number that is neither real nor a root of unity
+	std::complex<double> roots[NewtonPolynomial::c_MaxDegree];
+	std::complex<double> seed(0.4, 0.9);
+	roots[0] = 1.0;
+	for (int i = 1; i < degree; i++)
+		roots[i] = roots[i - 1] * seed;
+
+	for (int step = 0; step < c_RootIterations; step++) {
+		double largestMove = 0.0;
+		for (int i = 0; i < degree; i++) {
+			std::complex<double> value = coefficients[degree];
+			for (int j = degree - 1; j >= 0; j--)
+				value = value * roots[i] + coefficients[j];
+
+			std::complex<double> denominator = 1.0;
+			for (int j = 0; j < degree; j++) {
+				if (j != i)
+					denominator *= roots[i] - roots[j];
+			}
+			if (denominator == 0.0)
+				continue;
+
+			std::complex<double> move = value / denominator;
+			roots[i] -= move;
+			largestMove = std::max(largestMove, std::abs(move));
+		}
+		if (largestMove < c_RootPrecision)
+			break;
+	}
+
+	for (int i = 0; i < degree; i++)
+		polynomial.roots[i] = { static_cast<float>(roots[i].real()), static_cast<float>(roots[i].imag()) };
+}
+
+int Newton::Iterate(const NewtonPolynomial& polynomial, float zx, float zy, int maxIterations, int& root)
+{
+	const float tolerance = c_Tolerance * c_Tolerance;
+
+	for (int iters = 0; iters < maxIterations; iters++) {
+		for (int i = 0; i < polynomial.rootCount; i++) {
+			float x = zx - polynomial.roots[i].x;
+			float y = zy - polynomial.roots[i].y;
+			if (x * x + y * y < tolerance) {
+				root = i;
+				return iters;
+			}
+		}
+
+		float px, py, dx, dy;
+		Evaluate(polynomial, zx, zy, px, py, dx, dy);
+		float magnitude = dx * dx + dy * dy;
+		if (magnitude == 0.0f)
+			break;
+
+		// p / p', with p' conjugated over its squared magnitude
+		zx -= (px * dx + py * dy) / magnitude;
+		zy -= (py * dx - px * dy) / magnitude;
+	}
+
+	root = -1;
+	return maxIterations;
+}
+
+void Newton::IterateMany(const NewtonPolynomial& polynomial, const float* zxValues, const float* zyValues, int count, int maxIterations,
+	int* iterations, int* roots)
+{
+	const Float8 tolerance(c_Tolerance * c_Tolerance);
+	const Float8 one(1.0f);
+
+	for (int first = 0; first < count; first += Float8::c_Width) {
+		// a short last packet repeats its last point in the spare lanes
+		float xValues[Float8::c_Width];
+		float yValues[Float8::c_Width];
+		for (int lane = 0; lane < Float8::c_Width; lane++) {
+			int i = first + lane < count ? first + lane : count - 1;
+			xValues[lane] = zxValues[i];
+			yValues[lane] = zyValues[i];
+		}
+
+		Float8 zx = Float8::Load(xValues);
+		Float8 zy = Float8::Load(yValues);
+		Float8 isActive = Float8::True();
+		Float8 steps(0.0f);
+		// root index plus one, 0 for none yet
+		Float8 found(0.0f);
+
+		for (int iteration = 0; iteration < maxIterations; iteration++) {
+			for (int i = 0; i < polynomial.rootCount; i++) {
+				Float8 x = zx - Float8(polynomial.roots[i].x);
+				Float8 y = zy - Float8(polynomial.roots[i].y);
+				Float8 isHit = isActive & (x * x + y * y < tolerance);
+				found = Select(isHit, Float8(static_cast<float>(i + 1)), found);
+				isActive = AndNot(isActive, isHit);
+			}
+			if (!Any(isActive))
+				break;
+
+			// lanes that are done keep stepping, but their z is never read again;
+			// a zero derivative makes NaNs that never meet a root, as it should
+			Float8 px, py, dx, dy;
+			Evaluate(polynomial, zx, zy, px, py, dx, dy);
+			Float8 magnitude = dx * dx + dy * dy;
+			zx = zx - (px * dx + py * dy) / magnitude;
+			zy = zy - (py * dx - px * dy) / magnitude;
+			steps += isActive & one;
+		}
+
+		float stepValues[Float8::c_Width];
+		float foundValues[Float8::c_Width];
+		steps.Store(stepValues);
+		found.Store(foundValues);
+		for (int lane = 0; lane < Float8::c_Width && first + lane < count; lane++) {
+			roots[first + lane] = static_cast<int>(foundValues[lane]) - 1;
+			iterations[first + lane] = roots[first + lane] < 0 ? maxIterations : static_cast<int>(stepValues[lane]);
+		}
+	}
+}
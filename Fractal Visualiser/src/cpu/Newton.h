@@ -0,0 +1,48 @@
+#pragma once
+
+#include <core/FractalParams.h>
+
+// Newton's method on a NewtonPolynomial, z -= p(z) / p'(z), with p and p'
+// evaluated together by Horner's scheme. Iteration stops as soon as z is
+// within c_Tolerance of one of the polynomial's roots, found beforehand, so
+// most points stop after a handful of steps and the root they reached is
+// known without any search. newton.shader iterates the same way on the GPU.
+class Newton {
+public:
+	// a point has reached a root once it is this close
+	static constexpr float c_Tolerance = 1.0e-3f;
+	// Durand-Kerner steps at most, it stops early once the roots stop moving
+	static constexpr int c_RootIterations = 500;
+
+	// fills in the roots and their count, in double; leading zero coefficients lower the degree
+	static void FindRoots(NewtonPolynomial& polynomial);
+
+	// p(z) and p'(z), for float and Float8 alike
+	template<typename T>
+	static void Evaluate(const NewtonPolynomial& polynomial, T zx, T zy, T& px, T& py, T& dx, T& dy)
+	{
+		const Vec2* coefficients = polynomial.coefficients;
+		px = T(coefficients[polynomial.degree].x);
+		py = T(coefficients[polynomial.degree].y);
+		dx = T(0.0f);
+		dy = T(0.0f);
+		for (int i = polynomial.degree - 1; i >= 0; i--) {
+			// p' picks up p before p takes the next coefficient
+			T x = dx * zx - dy * zy + px;
+			dy = dx * zy + dy * zx + py;
+			dx = x;
+			x = px * zx - py * zy + T(coefficients[i].x);
+			py = px * zy + py * zx + T(coefficients[i].y);
+			px = x;
+		}
+	}
+
+	// steps taken before z came within c_Tolerance of a root, with root its
+	// index; maxIterations and -1 if it never did. The scalar reference the
+	// self checks hold IterateMany to
+	static int Iterate(const NewtonPolynomial& polynomial, float zx, float zy, int maxIterations, int& root);
+
+	// the same for count starting points, eight at a time in Float8 lanes
+	static void IterateMany(const NewtonPolynomial& polynomial, const float* zx, const float* zy, int count, int maxIterations,
+		int* iterations, int* roots);
+};
@@ -0,0 +1,39 @@
+#include "AccumulationBuffer.h"
+#include <renderer/GLState.h>
+
+AccumulationBuffer::AccumulationBuffer(int width, int height)
+	: m_Targets{ { width, height, GL_RGBA32F }, { width, height, GL_RGBA32F } }
+{
+}
+
+void AccumulationBuffer::Resize(int width, int height)
+{
+	if (width == m_Targets[0].GetWidth() && height == m_Targets[0].GetHeight())
+		return;
+
+	m_Targets[0].Resize(width, height);
+	m_Targets[1].Resize(width, height);
+	Reset();
+}
+
+void AccumulationBuffer::BeginSample()
+{
+	m_Targets[m_Current].GetColorAttachment().Bind(c_TextureUnit);
+	m_Targets[1 - m_Current].Bind();
+}
+
+void AccumulationBuffer::EndSample()
+{
+	m_Current = 1 - m_Current;
+	m_SampleIndex++;
+}
+
+void AccumulationBuffer::Present(int width, int height) const
+{
+	const Framebuffer& latest = m_Targets[m_Current];
+
+	Framebuffer::BindDefault(width, height);
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, latest.GetID());
+	glBlitFramebuffer(0, 0, latest.GetWidth(), latest.GetHeight(), 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
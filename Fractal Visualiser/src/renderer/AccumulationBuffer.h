@@ -0,0 +1,34 @@
+#pragma once
+
+#include <renderer/Framebuffer.h>
+
+// Running average of jittered frames for a still view. Two float targets are
+// used in turn: a sample reads the average so far from one and writes the new
+// average to the other, which is then shown on screen.
+class AccumulationBuffer {
+public:
+	// past this many samples the image has converged and is only redisplayed
+	static constexpr int c_MaxSamples = 256;
+	static constexpr unsigned int c_TextureUnit = 2;
+
+	AccumulationBuffer(int width, int height);
+
+	// starts over at the new size if it changed
+	void Resize(int width, int height);
+	void Reset() { m_SampleIndex = 0; }
+
+	int GetSampleIndex() const { return m_SampleIndex; }
+	bool IsConverged() const { return m_SampleIndex >= c_MaxSamples; }
+
+	// binds the target for the next sample and the history it blends with
+	void BeginSample();
+	void EndSample();
+
+	// copies the current average to the window framebuffer
+	void Present(int width, int height) const;
+
+private:
+	Framebuffer m_Targets[2];
+	int m_Current = 0;
+	int m_SampleIndex = 0;
+};
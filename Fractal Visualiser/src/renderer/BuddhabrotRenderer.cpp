@@ -0,0 +1,84 @@
+#include "BuddhabrotRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <core/AllocationCounter.h>
+#include <core/Trace.h>
+#include <renderer/GLState.h>
+
+constexpr int BuddhabrotRenderer::c_NebulabrotDivisors[Buddhabrot::c_NumChannels];
+
+BuddhabrotRenderer::BuddhabrotRenderer() : m_Image(1, 1, GL_RGBA8)
+{
+}
+
+void BuddhabrotRenderer::Update(const FractalParams& params, bool isNebulabrot, double now)
+{
+	Buddhabrot::Settings settings;
+	settings.width = params.width;
+	settings.height = params.height;
+	settings.locationX = params.location.x;
+	settings.locationY = params.location.y;
+	settings.zoom = params.zoom;
+	for (int channel = 0; channel < Buddhabrot::c_NumChannels; channel++)
+		settings.iterations[channel] = std::max(params.iterations / (isNebulabrot ? c_NebulabrotDivisors[channel] : 1), 1);
+
+	if (!m_HasSettings || !(settings == m_Sampler.GetSettings())) {
+		// a restart is one-off work; sizing the buffers here keeps the resolves that follow free of allocations
+		AllocationCounter::Exempt exempt;
+		m_Sampler.SetSettings(settings);
+		m_HasSettings = true;
+		m_Revision = 0;
+		size_t count = static_cast<size_t>(settings.width) * settings.height;
+		m_Density.resize(count * Buddhabrot::c_NumChannels);
+		m_Pixels.resize(count * 4);
+	}
+	m_Sampler.SetPaused(false);
+
+	// the last image stays up until the new view has samples of its own
+	if (now - m_LastResolve < c_ResolveInterval || m_Sampler.GetSampleCount() == 0)
+		return;
+	if (!m_Sampler.Resolve(m_Revision, m_Density))
+		return;
+	m_LastResolve = now;
+
+	TRACE_SCOPE("Buddhabrot Upload");
+	m_Image.Resize(settings.width, settings.height);
+	ToneMap();
+	m_Image.GetColorAttachment().Upload(m_Pixels.data());
+}
+
+void BuddhabrotRenderer::ToneMap()
+{
+	const Buddhabrot::Settings& settings = m_Sampler.GetSettings();
+	size_t count = static_cast<size_t>(settings.width) * settings.height;
+	if (m_Density.size() != count * Buddhabrot::c_NumChannels)
+		return;
+
+	float brightest[Buddhabrot::c_NumChannels] = {};
+	for (size_t i = 0; i < count; i++) {
+		for (int channel = 0; channel < Buddhabrot::c_NumChannels; channel++)
+			brightest[channel] = std::max(brightest[channel], m_Density[i * Buddhabrot::c_NumChannels + channel]);
+	}
+
+	float scale[Buddhabrot::c_NumChannels];
+	for (int channel = 0; channel < Buddhabrot::c_NumChannels; channel++)
+		scale[channel] = brightest[channel] > 0.0f ? 1.0f / brightest[channel] : 0.0f;
+
+	for (size_t i = 0; i < count; i++) {
+		for (int channel = 0; channel < Buddhabrot::c_NumChannels; channel++) {
+			float value = std::sqrt(m_Density[i * Buddhabrot::c_NumChannels + channel] * scale[channel]);
+			m_Pixels[i * 4 + channel] = static_cast<uint8_t>(std::min(value, 1.0f) * 255.0f + 0.5f);
+		}
+		m_Pixels[i * 4 + 3] = 255;
+	}
+}
+
+void BuddhabrotRenderer::Present(int windowWidth, int windowHeight) const
+{
+	Framebuffer::BindDefault(windowWidth, windowHeight);
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, m_Image.GetID());
+	glBlitFramebuffer(0, 0, m_Image.GetWidth(), m_Image.GetHeight(), 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
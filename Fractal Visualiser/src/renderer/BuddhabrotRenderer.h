@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <core/FractalParams.h>
+#include <cpu/Buddhabrot.h>
+#include <renderer/Framebuffer.h>
+
+// Shows a Buddhabrot while it is sampled. A few times a second the merged
+// histogram is fetched, tone mapped on this thread and uploaded to a texture,
+// which is scaled over the window the way the quality tiers' targets are.
+class BuddhabrotRenderer {
+public:
+	// seconds between fetches of the histogram, the sampling does not wait for them
+	static constexpr double c_ResolveInterval = 0.1;
+	// the Nebulabrot's green and blue caps are the red cap over these
+	static constexpr int c_NebulabrotDivisors[Buddhabrot::c_NumChannels] = { 1, 10, 100 };
+
+	BuddhabrotRenderer();
+
+	// starts the sampling over if the view changed, and picks up new samples;
+	// the view is the 2D fractals' view, the iteration count is the red cap
+	void Update(const FractalParams& params, bool isNebulabrot, double now);
+	// for while another fractal is shown
+	void SetPaused(bool isPaused) { m_Sampler.SetPaused(isPaused); }
+
+	// scales the image over the window's framebuffer
+	void Present(int windowWidth, int windowHeight) const;
+
+	const Buddhabrot& GetSampler() const { return m_Sampler; }
+
+private:
+	// square root of each channel over its brightest pixel, into m_Pixels
+	void ToneMap();
+
+	Buddhabrot m_Sampler;
+	Framebuffer m_Image;
+	bool m_HasSettings = false;
+	uint64_t m_Revision = 0;
+	double m_LastResolve = 0.0;
+
+	// sized with the view so fetching and uploading do not allocate
+	std::vector<float> m_Density;
+	std::vector<uint8_t> m_Pixels;
+};
@@ -0,0 +1,183 @@
+#include "ComputeRenderer.h"
+#include <renderer/GL43.h>
+#include <renderer/GLState.h>
+
+// matches WorkItem in escapetime_chunked.shader
+static constexpr size_t c_WorkItemSize = 16;
+
+ComputeRenderer::ComputeRenderer() : m_IterationBuffer(1, 1, GL_R32F)
+{
+	for (int i = 0; i < c_NumKernels; i++) {
+		std::string fractal = "#define FRACTAL " + std::to_string(i) + "\n#define HISTOGRAM_BINS " + std::to_string(IterationHistogram::c_NumBins) + "\n";
+		LoadKernel(m_Kernels[i], "res/shaders/escapetime_compute.shader", fractal);
+		LoadKernel(m_SeedKernels[i], "res/shaders/escapetime_chunked.shader", fractal + "#define SEED_PASS\n");
+		LoadKernel(m_ChunkKernels[i], "res/shaders/escapetime_chunked.shader", fractal);
+	}
+
+	m_ColorShader = std::make_unique<Shader>("res/shaders/iterationcolor.shader");
+	m_ColorIterationsLoc = m_ColorShader->GetLocation("iterations");
+	m_ColorLocs[0] = m_ColorShader->GetLocation("color_1");
+	m_ColorLocs[1] = m_ColorShader->GetLocation("color_2");
+	m_ColorLocs[2] = m_ColorShader->GetLocation("color_3");
+	m_ColorLocs[3] = m_ColorShader->GetLocation("color_4");
+
+	glGenBuffers(1, &m_TileQueue);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_TileQueue);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &m_WorkCounts);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_WorkCounts);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(2, m_WorkLists);
+}
+
+ComputeRenderer::~ComputeRenderer()
+{
+	GLState::ForgetBuffer(m_TileQueue);
+	GLState::ForgetBuffer(m_WorkCounts);
+	GLState::ForgetBuffer(m_WorkLists[0]);
+	GLState::ForgetBuffer(m_WorkLists[1]);
+	glDeleteBuffers(1, &m_TileQueue);
+	glDeleteBuffers(1, &m_WorkCounts);
+	glDeleteBuffers(2, m_WorkLists);
+}
+
+void ComputeRenderer::LoadKernel(Kernel& kernel, const std::string& filepath, const std::string& defines)
+{
+	kernel.Program = std::make_unique<Shader>(filepath, defines);
+
+	Shader& program = *kernel.Program;
+	kernel.Resolution = program.GetLocation("resolution");
+	kernel.Location = program.GetLocation("location");
+	kernel.MousePos = program.GetLocation("mousePos");
+	kernel.JuliaMode = program.GetLocation("juliaMode");
+	kernel.Zoom = program.GetLocation("zoom");
+	kernel.Iterations = program.GetLocation("iterations");
+	kernel.ChunkSize = program.GetLocation("chunkSize");
+	kernel.InputSlot = program.GetLocation("inputSlot");
+}
+
+bool ComputeRenderer::IsValid() const
+{
+	for (int i = 0; i < c_NumKernels; i++) {
+		if (m_Kernels[i].Program->GetID() == 0 || m_SeedKernels[i].Program->GetID() == 0 || m_ChunkKernels[i].Program->GetID() == 0)
+			return false;
+	}
+	return m_ColorShader->GetID() != 0;
+}
+
+void ComputeRenderer::BindKernel(const Kernel& kernel, const FractalParams& params)
+{
+	kernel.Program->Bind();
+	glUniform2i(kernel.Resolution, params.width, params.height);
+	glUniform2f(kernel.Location, params.location.x, params.location.y);
+	glUniform2f(kernel.MousePos, params.juliaConstant.x, params.juliaConstant.y);
+	glUniform1i(kernel.JuliaMode, params.juliaMode);
+	glUniform1f(kernel.Zoom, params.zoom);
+	glUniform1i(kernel.Iterations, params.iterations);
+	glUniform1i(kernel.ChunkSize, m_ChunkSize);
+}
+
+void ComputeRenderer::Dispatch(const FractalParams& params)
+{
+	int kernelIndex = params.fractal < c_NumKernels ? params.fractal : 0;
+
+	m_IterationBuffer.Resize(params.width, params.height);
+	glBindImageTexture(0, m_IterationBuffer.GetID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	m_Histogram.Begin(params.iterations);
+
+	if (m_ChunkSize > 0 && m_ChunkSize < params.iterations)
+		DispatchChunked(params, m_SeedKernels[kernelIndex], m_ChunkKernels[kernelIndex]);
+	else
+		DispatchTiles(params, m_Kernels[kernelIndex]);
+
+	// the colour pass samples the image, the next dispatch rewrites the counters
+	// and the histogram is read back with glGetBufferSubData
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	m_Histogram.End();
+}
+
+void ComputeRenderer::DispatchTiles(const FractalParams& params, const Kernel& kernel)
+{
+	BindKernel(kernel, params);
+
+	// rewind the tile queue
+	unsigned int zero = 0;
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_TileQueue);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_TileQueue);
+
+	int tilesX = (params.width + c_TileSize - 1) / c_TileSize;
+	int tilesY = (params.height + c_TileSize - 1) / c_TileSize;
+	int groups = tilesX * tilesY < m_PersistentGroups ? tilesX * tilesY : m_PersistentGroups;
+	glDispatchCompute(groups, 1, 1);
+}
+
+void ComputeRenderer::ResizeWorkLists(int width, int height)
+{
+	size_t capacity = static_cast<size_t>(width) * height;
+	if (capacity <= m_WorkListCapacity)
+		return;
+
+	for (int i = 0; i < 2; i++) {
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_WorkLists[i]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * c_WorkItemSize, nullptr, GL_DYNAMIC_COPY);
+	}
+	m_WorkListCapacity = capacity;
+}
+
+void ComputeRenderer::DispatchChunked(const FractalParams& params, const Kernel& seed, const Kernel& chunk)
+{
+	ResizeWorkLists(params.width, params.height);
+
+	unsigned int zero[2] = { 0, 0 };
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_WorkCounts);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_WorkCounts);
+
+	// seed: every pixel runs its first chunk, survivors land in list 0
+	BindKernel(seed, params);
+	glUniform1i(seed.InputSlot, 1);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_WorkLists[0]);
+	glDispatchCompute((params.width + c_TileSize - 1) / c_TileSize, (params.height + c_TileSize - 1) / c_TileSize, 1);
+
+	// continue from the list until the cap; once the list is empty a pass only
+	// reads the count and exits, so the passes are issued without reading it back
+	int passes = (params.iterations - 1) / m_ChunkSize;
+	int listGroups = static_cast<int>((m_WorkListCapacity + c_ListGroupSize - 1) / c_ListGroupSize);
+	int groups = listGroups < m_PersistentGroups ? listGroups : m_PersistentGroups;
+
+	BindKernel(chunk, params);
+	for (int pass = 0; pass < passes; pass++) {
+		int input = pass % 2;
+		int output = 1 - input;
+
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_WorkCounts);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, output * sizeof(unsigned int), sizeof(unsigned int), zero);
+
+		glUniform1i(chunk.InputSlot, input);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_WorkLists[input]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_WorkLists[output]);
+		glDispatchCompute(groups, 1, 1);
+	}
+}
+
+void ComputeRenderer::DrawColorPass(const FractalParams& params, const VertexArray& quad)
+{
+	m_ColorShader->Bind();
+	glUniform1i(m_ColorIterationsLoc, params.iterations);
+	for (int i = 0; i < 4; i++)
+		glUniform3f(m_ColorLocs[i], params.colors[i][0], params.colors[i][1], params.colors[i][2]);
+
+	m_IterationBuffer.Bind(0);
+	quad.Bind();
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void ComputeRenderer::Render(const FractalParams& params, const VertexArray& quad)
+{
+	Dispatch(params);
+	DrawColorPass(params, quad);
+}
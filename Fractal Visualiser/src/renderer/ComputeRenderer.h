@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <core/FractalParams.h>
+#include <shader/Shader.h>
+#include <renderer/IterationHistogram.h>
+#include <renderer/Texture.h>
+#include <vertex/VertexArray.h>
+
+// GL 4.3 escape time backend for the 2D fractals. A fixed number of persistent
+// workgroups pull 16x16 tiles from an atomic counter until the image is done, so
+// workgroups that land on cheap exterior tiles go on to take more work instead
+// of idling while interior tiles finish. The kernel writes smooth iteration
+// counts to an r32f image which a separate colour pass turns into the palette.
+//
+// With a chunk size set, iteration is split into passes instead: each pass runs
+// at most chunk size iterations per pixel and compacts the pixels still alive
+// into a dense work list for the next pass, so lanes are never held up by a few
+// slow neighbours for more than one chunk.
+//
+// Either way the kernels bin every pixel's escape count into the iteration
+// histogram as they go.
+class ComputeRenderer {
+public:
+	static constexpr int c_TileSize = 16;
+	static constexpr int c_ListGroupSize = 256;
+	static constexpr int c_NumKernels = 3;
+
+	ComputeRenderer();
+	~ComputeRenderer();
+
+	// false when a kernel failed to build, in which case the fragment path must be used
+	bool IsValid() const;
+
+	// fills the iteration buffer, resizing it to the requested resolution
+	void Dispatch(const FractalParams& params);
+	// colours the iteration buffer onto the currently bound framebuffer
+	void DrawColorPass(const FractalParams& params, const VertexArray& quad);
+
+	void Render(const FractalParams& params, const VertexArray& quad);
+
+	const Texture& GetIterationBuffer() const { return m_IterationBuffer; }
+	// a few frames behind the image
+	const IterationHistogram& GetHistogram() const { return m_Histogram; }
+
+	int GetPersistentGroups() const { return m_PersistentGroups; }
+	void SetPersistentGroups(int groups) { m_PersistentGroups = groups < 1 ? 1 : groups; }
+
+	// 0 renders every pixel to completion in one pass
+	int GetChunkSize() const { return m_ChunkSize; }
+	void SetChunkSize(int chunkSize) { m_ChunkSize = chunkSize < 0 ? 0 : chunkSize; }
+
+private:
+	struct Kernel {
+		std::unique_ptr<Shader> Program;
+		int Resolution;
+		int Location;
+		int MousePos;
+		int JuliaMode;
+		int Zoom;
+		int Iterations;
+		int ChunkSize;
+		int InputSlot;
+	};
+
+	void LoadKernel(Kernel& kernel, const std::string& filepath, const std::string& defines);
+	void BindKernel(const Kernel& kernel, const FractalParams& params);
+
+	void DispatchTiles(const FractalParams& params, const Kernel& kernel);
+	void DispatchChunked(const FractalParams& params, const Kernel& seed, const Kernel& chunk);
+	void ResizeWorkLists(int width, int height);
+
+	Kernel m_Kernels[c_NumKernels];
+	Kernel m_SeedKernels[c_NumKernels];
+	Kernel m_ChunkKernels[c_NumKernels];
+
+	std::unique_ptr<Shader> m_ColorShader;
+	int m_ColorIterationsLoc;
+	int m_ColorLocs[4];
+
+	Texture m_IterationBuffer;
+	IterationHistogram m_Histogram;
+	unsigned int m_TileQueue;
+	int m_PersistentGroups = 128;
+
+	// chunked mode: two work lists used in turn as input and output, plus their counts
+	unsigned int m_WorkCounts;
+	unsigned int m_WorkLists[2];
+	size_t m_WorkListCapacity = 0;
+	int m_ChunkSize = 0;
+};
@@ -0,0 +1,35 @@
+#include "ConePrepass.h"
+#include <renderer/GLState.h>
+
+ConePrepass::ConePrepass() : m_Depth(1, 1, GL_R32F)
+{
+	m_Shader = std::make_unique<Shader>("res/shaders/mandelbulb.shader", "#define CONE_PREPASS\n");
+	m_ResolutionLoc = m_Shader->GetLocation("resolution");
+	m_LocationLoc = m_Shader->GetLocation("location");
+	m_IterationsLoc = m_Shader->GetLocation("iterations");
+	m_PowerLoc = m_Shader->GetLocation("power");
+	m_BlockLoc = m_Shader->GetLocation("coneBlock");
+}
+
+bool ConePrepass::IsValid() const
+{
+	return m_Shader->GetID() != 0;
+}
+
+void ConePrepass::Render(const FractalParams& params, float power, const VertexArray& quad)
+{
+	m_Depth.Resize((params.width + m_BlockSize - 1) / m_BlockSize, (params.height + m_BlockSize - 1) / m_BlockSize);
+	m_Depth.Bind();
+
+	m_Shader->Bind();
+	glUniform2i(m_ResolutionLoc, params.width, params.height);
+	glUniform2f(m_LocationLoc, params.location.x, params.location.y);
+	glUniform1i(m_IterationsLoc, params.iterations);
+	glUniform1f(m_PowerLoc, power);
+	glUniform1i(m_BlockLoc, m_BlockSize);
+
+	quad.Bind();
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+	Framebuffer::BindDefault(params.width, params.height);
+}
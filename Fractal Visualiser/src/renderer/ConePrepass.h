@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <core/FractalParams.h>
+#include <shader/Shader.h>
+#include <renderer/Framebuffer.h>
+#include <vertex/VertexArray.h>
+
+// Low resolution depth pass for the Mandelbulb. Each texel marches one cone
+// wide enough to hold the rays of a block of full resolution pixels, and stores
+// the distance every one of those rays can skip without passing a surface. The
+// full resolution pass starts its rays there instead of at the camera.
+class ConePrepass {
+public:
+	ConePrepass();
+
+	bool IsValid() const;
+
+	// renders the depth texture for the given view, then rebinds the window framebuffer
+	void Render(const FractalParams& params, float power, const VertexArray& quad);
+
+	const Texture& GetDepth() const { return m_Depth.GetColorAttachment(); }
+
+	int GetBlockSize() const { return m_BlockSize; }
+	void SetBlockSize(int blockSize) { m_BlockSize = blockSize < 1 ? 1 : blockSize; }
+
+private:
+	std::unique_ptr<Shader> m_Shader;
+	int m_ResolutionLoc;
+	int m_LocationLoc;
+	int m_IterationsLoc;
+	int m_PowerLoc;
+	int m_BlockLoc;
+
+	Framebuffer m_Depth;
+	int m_BlockSize = 8;
+};
@@ -0,0 +1,109 @@
+#include "DistanceVolume.h"
+#include <core/AllocationCounter.h>
+#include <core/Trace.h>
+#include <cpu/Mandelbulb.h>
+#include <glad/glad.h>
+#include <chrono>
+
+DistanceVolume::DistanceVolume(int size) : m_Size(size)
+{
+	glGenTextures(1, &m_Texture);
+	glBindTexture(GL_TEXTURE_3D, m_Texture);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R32F, m_Size, m_Size, m_Size, 0, GL_RED, GL_FLOAT, nullptr);
+}
+
+DistanceVolume::~DistanceVolume()
+{
+	if (m_Worker.joinable()) {
+		m_isCancelled = true;
+		m_Worker.join();
+	}
+	glDeleteTextures(1, &m_Texture);
+}
+
+bool DistanceVolume::Request(float power, int iterations)
+{
+	if (m_Worker.joinable() && m_isFinished) {
+		m_Worker.join();
+		if (!m_isCancelled)
+			Upload();
+	}
+
+	if (m_HasVolume && m_Power == power && m_Iterations == iterations)
+		return true;
+
+	if (m_Worker.joinable()) {
+		// a stale bake is not worth finishing, the next call starts the right one
+		if (m_BakePower != power || m_BakeIterations != iterations)
+			m_isCancelled = true;
+		return false;
+	}
+
+	m_BakePower = power;
+	m_BakeIterations = iterations;
+	m_isFinished = false;
+	m_isCancelled = false;
+	// a new bake is rare next to the frames drawn with it
+	AllocationCounter::Exempt exempt;
+	m_Worker = std::thread(&DistanceVolume::Bake, this, power, iterations);
+	return false;
+}
+
+void DistanceVolume::Bind(unsigned int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, m_Texture);
+}
+
+void DistanceVolume::Bake(float power, int iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	m_Data.resize(static_cast<size_t>(m_Size) * m_Size * m_Size);
+
+	// slices are handed out one at a time so uneven slices do not leave cores idle
+	std::atomic<int> nextSlice{ 0 };
+	auto bakeSlices = [&]() {
+		Trace::SetThreadName("Volume Bake");
+		TRACE_SCOPE("Bake Slices");
+		float cell = 2.0f * Mandelbulb::c_BoundRadius / m_Size;
+		for (int z = nextSlice++; z < m_Size && !m_isCancelled; z = nextSlice++) {
+			float* slice = &m_Data[static_cast<size_t>(z) * m_Size * m_Size];
+			float pz = (z + 0.5f) * cell - Mandelbulb::c_BoundRadius;
+			for (int y = 0; y < m_Size; y++) {
+				float py = (y + 0.5f) * cell - Mandelbulb::c_BoundRadius;
+				for (int x = 0; x < m_Size; x++) {
+					float px = (x + 0.5f) * cell - Mandelbulb::c_BoundRadius;
+					slice[y * m_Size + x] = Mandelbulb::Distance(px, py, pz, power, iterations);
+				}
+			}
+		}
+	};
+
+	unsigned int numThreads = std::thread::hardware_concurrency();
+	std::vector<std::thread> helpers;
+	for (unsigned int i = 1; i < numThreads; i++)
+		helpers.emplace_back(bakeSlices);
+	bakeSlices();
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	m_BakeMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_isFinished = true;
+}
+
+void DistanceVolume::Upload()
+{
+	glBindTexture(GL_TEXTURE_3D, m_Texture);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, m_Size, m_Size, m_Size, GL_RED, GL_FLOAT, m_Data.data());
+
+	m_HasVolume = true;
+	m_Power = m_BakePower;
+	m_Iterations = m_BakeIterations;
+	m_LastBakeMilliseconds = m_BakeMilliseconds;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Mandelbulb distance estimates baked into a 3D texture over the bounding cube,
+// so the ray marcher can cross empty space with single texture reads. Bakes run
+// on a background thread spread over every core, and the texture is only swapped
+// in once a bake for the current power and iteration count has finished.
+class DistanceVolume {
+public:
+	static constexpr int c_DefaultSize = 96;
+	static constexpr unsigned int c_TextureUnit = 1;
+
+	DistanceVolume(int size = c_DefaultSize);
+	~DistanceVolume();
+
+	// true when the texture holds these parameters. Otherwise a bake for them is
+	// started, or queued behind the one in flight, and false is returned until
+	// it has been uploaded.
+	bool Request(float power, int iterations);
+
+	void Bind(unsigned int unit) const;
+
+	int GetSize() const { return m_Size; }
+	bool IsBaking() const { return m_Worker.joinable(); }
+	float GetLastBakeMilliseconds() const { return m_LastBakeMilliseconds; }
+
+private:
+	void Bake(float power, int iterations);
+	void Upload();
+
+	unsigned int m_Texture;
+	int m_Size;
+
+	// what the texture currently holds
+	bool m_HasVolume = false;
+	float m_Power = 0.0f;
+	int m_Iterations = 0;
+
+	// bake in flight, m_Data is only touched by the worker until m_isFinished is set
+	std::thread m_Worker;
+	std::atomic<bool> m_isFinished{ false };
+	std::atomic<bool> m_isCancelled{ false };
+	float m_BakePower = 0.0f;
+	int m_BakeIterations = 0;
+	std::vector<float> m_Data;
+	float m_BakeMilliseconds = 0.0f;
+
+	float m_LastBakeMilliseconds = 0.0f;
+};
@@ -0,0 +1,39 @@
+#include "Framebuffer.h"
+#include <renderer/GLState.h>
+#include <iostream>
+
+Framebuffer::Framebuffer(int width, int height, unsigned int internalFormat) : m_Color(width, height, internalFormat)
+{
+	glGenFramebuffers(1, &m_ID);
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, m_ID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Color.GetID(), 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer is not complete" << std::endl;
+
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer()
+{
+	GLState::ForgetFramebuffer(m_ID);
+	glDeleteFramebuffers(1, &m_ID);
+}
+
+void Framebuffer::Bind() const
+{
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, m_ID);
+	GLState::Viewport(0, 0, m_Color.GetWidth(), m_Color.GetHeight());
+}
+
+void Framebuffer::BindDefault(int width, int height)
+{
+	GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::Viewport(0, 0, width, height);
+}
+
+void Framebuffer::Resize(int width, int height)
+{
+	// the attachment follows the texture, so only the storage needs replacing
+	m_Color.Resize(width, height);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <renderer/Texture.h>
+
+// Offscreen render target with a single colour texture.
+class Framebuffer {
+public:
+	Framebuffer(int width, int height, unsigned int internalFormat);
+	~Framebuffer();
+
+	// binds for drawing and sets the viewport to cover the whole target
+	void Bind() const;
+	// back to the window, with the viewport restored to its size
+	static void BindDefault(int width, int height);
+
+	void Resize(int width, int height);
+
+	const Texture& GetColorAttachment() const { return m_Color; }
+	unsigned int GetID() const { return m_ID; }
+	int GetWidth() const { return m_Color.GetWidth(); }
+	int GetHeight() const { return m_Color.GetHeight(); }
+
+private:
+	unsigned int m_ID;
+	Texture m_Color;
+};
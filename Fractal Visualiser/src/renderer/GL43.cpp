@@ -0,0 +1,28 @@
+#include "GL43.h"
+
+#ifndef GL_VERSION_4_3
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+PFNGLDISPATCHCOMPUTEINDIRECTPROC glad_glDispatchComputeIndirect = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture = nullptr;
+#endif
+
+bool GL43::s_isLoaded = false;
+
+bool GL43::Load(GLADloadproc load)
+{
+	if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 3))
+		return false;
+
+#ifndef GL_VERSION_4_3
+	glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+	glad_glDispatchComputeIndirect = (PFNGLDISPATCHCOMPUTEINDIRECTPROC)load("glDispatchComputeIndirect");
+	glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+	glad_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+
+	s_isLoaded = glad_glDispatchCompute && glad_glDispatchComputeIndirect && glad_glMemoryBarrier && glad_glBindImageTexture;
+#else
+	s_isLoaded = true;
+#endif
+	return s_isLoaded;
+}
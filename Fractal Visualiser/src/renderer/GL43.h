@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// The bundled glad loader only covers GL 3.3 core. The compute backend needs a
+// handful of GL 4.3 entry points, so they are declared and loaded here in the
+// same style as glad. When the context is older, Load returns false and the
+// fragment shader path is used instead.
+
+#ifndef GL_VERSION_4_3
+
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_ATOMIC_COUNTER_BUFFER 0x92C0
+#define GL_DISPATCH_INDIRECT_BUFFER 0x90EE
+#define GL_MAX_COMPUTE_WORK_GROUP_COUNT 0x91BE
+
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_ELEMENT_ARRAY_BARRIER_BIT 0x00000002
+#define GL_UNIFORM_BARRIER_BIT 0x00000004
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_PIXEL_BUFFER_BARRIER_BIT 0x00000080
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_ATOMIC_COUNTER_BARRIER_BIT 0x00001000
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEINDIRECTPROC)(GLintptr indirect);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+
+extern PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+extern PFNGLDISPATCHCOMPUTEINDIRECTPROC glad_glDispatchComputeIndirect;
+extern PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+extern PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture;
+
+#define glDispatchCompute glad_glDispatchCompute
+#define glDispatchComputeIndirect glad_glDispatchComputeIndirect
+#define glMemoryBarrier glad_glMemoryBarrier
+#define glBindImageTexture glad_glBindImageTexture
+
+#endif
+
+class GL43
+{
+private:
+	static bool s_isLoaded;
+
+public:
+	// call once after gladLoadGLLoader, with the same loader
+	static bool Load(GLADloadproc load);
+
+	inline static bool IsLoaded() { return s_isLoaded; }
+};
@@ -0,0 +1,138 @@
+#include "GLState.h"
+
+thread_local unsigned int GLState::s_Program = GLState::c_Unknown;
+thread_local unsigned int GLState::s_VertexArray = GLState::c_Unknown;
+thread_local unsigned int GLState::s_Buffers[GLState::c_NumBufferTargets] = { GLState::c_Unknown, GLState::c_Unknown };
+thread_local unsigned int GLState::s_DrawFramebuffer = GLState::c_Unknown;
+thread_local unsigned int GLState::s_ReadFramebuffer = GLState::c_Unknown;
+thread_local int GLState::s_Viewport[4] = { -1, -1, -1, -1 };
+thread_local unsigned int GLState::s_SkippedThisFrame = 0;
+thread_local unsigned int GLState::s_SkippedLastFrame = 0;
+
+int GLState::BufferSlot(unsigned int target)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		return 0;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return 1;
+	}
+	// targets we do not track are always passed through
+	return -1;
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+	if (s_Program == program) {
+		s_SkippedThisFrame++;
+		return;
+	}
+	glUseProgram(program);
+	s_Program = program;
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray)
+{
+	if (s_VertexArray == vertexArray) {
+		s_SkippedThisFrame++;
+		return;
+	}
+	glBindVertexArray(vertexArray);
+	s_VertexArray = vertexArray;
+
+	// the element array binding belongs to the vertex array object
+	s_Buffers[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = c_Unknown;
+}
+
+void GLState::BindBuffer(unsigned int target, unsigned int buffer)
+{
+	int slot = BufferSlot(target);
+	if (slot < 0) {
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (s_Buffers[slot] == buffer) {
+		s_SkippedThisFrame++;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	s_Buffers[slot] = buffer;
+}
+
+void GLState::BindFramebuffer(unsigned int target, unsigned int framebuffer)
+{
+	bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+	bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+	if ((!draw || s_DrawFramebuffer == framebuffer) && (!read || s_ReadFramebuffer == framebuffer)) {
+		s_SkippedThisFrame++;
+		return;
+	}
+	glBindFramebuffer(target, framebuffer);
+	if (draw)
+		s_DrawFramebuffer = framebuffer;
+	if (read)
+		s_ReadFramebuffer = framebuffer;
+}
+
+void GLState::Viewport(int x, int y, int width, int height)
+{
+	if (s_Viewport[0] == x && s_Viewport[1] == y && s_Viewport[2] == width && s_Viewport[3] == height) {
+		s_SkippedThisFrame++;
+		return;
+	}
+	glViewport(x, y, width, height);
+	s_Viewport[0] = x;
+	s_Viewport[1] = y;
+	s_Viewport[2] = width;
+	s_Viewport[3] = height;
+}
+
+void GLState::ForgetProgram(unsigned int program)
+{
+	// a deleted program stays in use until another is bound, so its name may come back while "bound"
+	if (s_Program == program)
+		s_Program = c_Unknown;
+}
+
+void GLState::ForgetVertexArray(unsigned int vertexArray)
+{
+	// deleting the bound vertex array reverts the binding to zero
+	if (s_VertexArray == vertexArray) {
+		s_VertexArray = 0;
+		s_Buffers[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = c_Unknown;
+	}
+}
+
+void GLState::ForgetBuffer(unsigned int buffer)
+{
+	for (int i = 0; i < c_NumBufferTargets; i++) {
+		if (s_Buffers[i] == buffer)
+			s_Buffers[i] = 0;
+	}
+}
+
+void GLState::ForgetFramebuffer(unsigned int framebuffer)
+{
+	if (s_DrawFramebuffer == framebuffer)
+		s_DrawFramebuffer = 0;
+	if (s_ReadFramebuffer == framebuffer)
+		s_ReadFramebuffer = 0;
+}
+
+void GLState::Invalidate()
+{
+	s_Program = c_Unknown;
+	s_VertexArray = c_Unknown;
+	for (int i = 0; i < c_NumBufferTargets; i++)
+		s_Buffers[i] = c_Unknown;
+	s_DrawFramebuffer = c_Unknown;
+	s_ReadFramebuffer = c_Unknown;
+	s_Viewport[0] = s_Viewport[1] = s_Viewport[2] = s_Viewport[3] = -1;
+}
+
+void GLState::BeginFrame()
+{
+	s_SkippedLastFrame = s_SkippedThisFrame;
+	s_SkippedThisFrame = 0;
+}
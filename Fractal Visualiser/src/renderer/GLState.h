@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Shadow copy of the GL bindings the renderer touches. Every bind goes through
+// here so that a call which would not change anything never reaches the driver.
+// ImGui's OpenGL3 backend saves and restores everything it binds, so the cache
+// stays valid across ImGui_ImplOpenGL3_RenderDrawData.
+//
+// Bindings belong to a context and a context is current on one thread, so
+// there is one cache per thread; the render thread's context keeps its own.
+class GLState
+{
+private:
+	static constexpr unsigned int c_Unknown = 0xFFFFFFFF;
+	static constexpr int c_NumBufferTargets = 2;
+
+	static thread_local unsigned int s_Program;
+	static thread_local unsigned int s_VertexArray;
+	static thread_local unsigned int s_Buffers[c_NumBufferTargets];
+	static thread_local unsigned int s_DrawFramebuffer;
+	static thread_local unsigned int s_ReadFramebuffer;
+	static thread_local int s_Viewport[4];
+
+	// redundant calls skipped
+	static thread_local unsigned int s_SkippedThisFrame;
+	static thread_local unsigned int s_SkippedLastFrame;
+
+	static int BufferSlot(unsigned int target);
+
+public:
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vertexArray);
+	static void BindBuffer(unsigned int target, unsigned int buffer);
+	static void BindFramebuffer(unsigned int target, unsigned int framebuffer);
+	static void Viewport(int x, int y, int width, int height);
+
+	// call before the matching glDelete* so a recycled name is not mistaken for a bound one
+	static void ForgetProgram(unsigned int program);
+	static void ForgetVertexArray(unsigned int vertexArray);
+	static void ForgetBuffer(unsigned int buffer);
+	static void ForgetFramebuffer(unsigned int framebuffer);
+
+	// forget everything, for when code outside the cache has changed GL state
+	static void Invalidate();
+
+	static void BeginFrame();
+	inline static unsigned int GetSkippedLastFrame() { return s_SkippedLastFrame; }
+};
@@ -0,0 +1,62 @@
+#include "GpuTimer.h"
+#include <glad/glad.h>
+
+GpuTimer::GpuTimer()
+{
+	glGenQueries(c_NumQueries, m_Queries);
+	glGenQueries(c_NumQueries, m_Timestamps);
+}
+
+GpuTimer::~GpuTimer()
+{
+	glDeleteQueries(c_NumQueries, m_Queries);
+	glDeleteQueries(c_NumQueries, m_Timestamps);
+}
+
+void GpuTimer::Begin(int tag)
+{
+	// every slot still in flight, skip this measurement rather than wait
+	if (m_Pending == c_NumQueries)
+		return;
+
+	m_Tags[m_Next] = tag;
+	glQueryCounter(m_Timestamps[m_Next], GL_TIMESTAMP);
+	glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Next]);
+	m_isRunning = true;
+}
+
+void GpuTimer::End()
+{
+	if (!m_isRunning)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_isRunning = false;
+	m_Next = (m_Next + 1) % c_NumQueries;
+	m_Pending++;
+}
+
+bool GpuTimer::Poll(double& milliseconds, int& tag, uint64_t& startNanoseconds)
+{
+	if (m_Pending == 0)
+		return false;
+
+	GLint available = 0;
+	glGetQueryObjectiv(m_Queries[m_Oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(m_Queries[m_Oldest], GL_QUERY_RESULT, &nanoseconds);
+	milliseconds = nanoseconds * 1e-6;
+	tag = m_Tags[m_Oldest];
+
+	// the timestamp was issued first, so it is ready too
+	GLuint64 start = 0;
+	glGetQueryObjectui64v(m_Timestamps[m_Oldest], GL_QUERY_RESULT, &start);
+	startNanoseconds = start;
+
+	m_Oldest = (m_Oldest + 1) % c_NumQueries;
+	m_Pending--;
+	return true;
+}
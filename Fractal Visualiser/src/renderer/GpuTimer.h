@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// GL_TIME_ELAPSED queries kept in a small ring, so a result is read a few
+// frames after it was issued instead of stalling the pipeline waiting for it.
+// Each query carries a tag chosen by the caller, to tell which kind of frame a
+// late result belongs to, and a GL_TIMESTAMP of when the GPU started on it.
+class GpuTimer {
+public:
+	static constexpr int c_NumQueries = 4;
+
+	GpuTimer();
+	~GpuTimer();
+
+	void Begin(int tag = 0);
+	void End();
+
+	// the oldest finished measurement not read yet, false when none is ready
+	bool Poll(double& milliseconds, int& tag, uint64_t& startNanoseconds);
+
+private:
+	unsigned int m_Queries[c_NumQueries];
+	unsigned int m_Timestamps[c_NumQueries];
+	int m_Tags[c_NumQueries] = {};
+	// next slot to issue, and oldest issued slot still to be read
+	int m_Next = 0;
+	int m_Oldest = 0;
+	int m_Pending = 0;
+	bool m_isRunning = false;
+};
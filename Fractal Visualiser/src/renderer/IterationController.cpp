@@ -0,0 +1,186 @@
+#include "IterationController.h"
+#include <cpu/EscapeTime.h>
+#include <cpu/Newton.h>
+#include <algorithm>
+#include <cmath>
+
+// the application's starting view and cap
+static constexpr float c_HomeZoom = 2.0f;
+static constexpr int c_HomeIterations = 200;
+// raises smaller than this are not worth a change
+static constexpr float c_MinRaiseFactor = 1.1f;
+
+int IterationController::EstimateForZoom(float zoom)
+{
+	// the home cap, plus half of it again for every halving of the view
+	float halvings = std::max(0.0f, std::log2(c_HomeZoom / zoom));
+	int estimate = static_cast<int>(c_HomeIterations * (1.0f + 0.5f * halvings));
+	return std::min(std::max(estimate, c_MinIterations), c_MaxIterations);
+}
+
+EscapeStats IterationController::FromHistogram(const IterationHistogram& histogram)
+{
+	EscapeStats stats;
+	if (!histogram.HasResult())
+		return stats;
+
+	const float* fractions = histogram.GetFractions();
+	int first = IterationHistogram::c_NumBins - static_cast<int>(IterationHistogram::c_NumBins * c_NearCapShare + 0.5f);
+	for (int i = first; i < IterationHistogram::c_NumBins; i++)
+		stats.nearCapFraction += fractions[i];
+
+	stats.iterations = histogram.GetIterations();
+	stats.capFraction = histogram.GetCapFraction();
+	return stats;
+}
+
+bool IterationController::SampleCpu(const FractalParams& params, EscapeStats& stats)
+{
+	if (params.iterations != m_SampleIterations) {
+		RestartSample();
+		m_SampleIterations = params.iterations;
+	}
+
+	int nearCap = params.iterations - static_cast<int>(params.iterations * c_NearCapShare);
+	const int count = c_SampleColumns * c_SampleRows;
+	long long spent = 0;
+
+	// pixel centres of an even grid over the window, so the view's aspect is kept;
+	// the budget is checked between pixels, so one frame never runs far over it
+	while (m_SampleNext < count && spent < c_SampleBudget) {
+		int row = m_SampleNext / c_SampleColumns;
+		int first = m_SampleNext % c_SampleColumns;
+		int last = first + 1;
+		int y = (2 * row + 1) * params.height / (2 * c_SampleRows);
+		int counts[c_SampleColumns];
+		if (params.fractal == FRACTAL_NEWTON) {
+			// the rest of the row at once through the SIMD kernel, starting from each pixel's point;
+			// most points reach a root in a handful of steps
+			float zx[c_SampleColumns];
+			float zy[c_SampleColumns];
+			int roots[c_SampleColumns];
+			last = c_SampleColumns;
+			for (int column = first; column < last; column++) {
+				// Julia mode means nothing here, the pixel's point is z whichever slot it lands in
+				float cx, cy, startX, startY;
+				EscapeTime::MapPixel(params, (2 * column + 1) * params.width / (2 * c_SampleColumns), y, cx, cy, startX, startY);
+				zx[column] = params.juliaMode ? startX : cx;
+				zy[column] = params.juliaMode ? startY : cy;
+			}
+			Newton::IterateMany(params.newton, zx + first, zy + first, last - first, params.iterations, counts + first, roots + first);
+		}
+		else {
+			counts[first] = EscapeTime::CountPixel(params, (2 * first + 1) * params.width / (2 * c_SampleColumns), y);
+		}
+
+		for (int column = first; column < last; column++) {
+			int iterations = counts[column];
+			if (iterations >= params.iterations)
+				m_SampleCapped++;
+			else if (iterations >= nearCap)
+				m_SampleNear++;
+			spent += iterations + 1;
+		}
+		m_SampleNext = row * c_SampleColumns + last;
+	}
+
+	if (m_SampleNext < count)
+		return false;
+
+	float samples = static_cast<float>(count);
+	stats.iterations = params.iterations;
+	stats.capFraction = m_SampleCapped / samples;
+	stats.nearCapFraction = m_SampleNear / samples;
+	RestartSample();
+	return true;
+}
+
+void IterationController::RestartSample()
+{
+	m_SampleNext = 0;
+	m_SampleCapped = 0;
+	m_SampleNear = 0;
+}
+
+int IterationController::Update(int iterations, float zoom, const EscapeStats& stats)
+{
+	m_UpdatesSinceChange = std::min(m_UpdatesSinceChange + 1, c_SettleUpdates);
+
+	int floor = std::max(c_MinIterations, EstimateForZoom(zoom) / 2);
+	if (iterations < floor) {
+		m_Votes = 0;
+		m_Status = "Raised to the floor for this zoom";
+		return ChangeTo(iterations, floor);
+	}
+
+	// nothing new, or counted before the last change
+	if (stats.iterations != iterations)
+		return iterations;
+
+	// a view that is mostly at the cap may be mostly false interior, which a lower cap only makes worse
+	bool isOverCeiling = m_FrameMilliseconds > m_CeilingMilliseconds;
+	bool isMostlyCapped = stats.capFraction > c_HoldCapAbove;
+	int vote = 0;
+	if (isOverCeiling || (stats.nearCapFraction < c_LowerBelow && !isMostlyCapped))
+		vote = -1;
+	else if (stats.nearCapFraction > c_RaiseAbove)
+		vote = 1;
+
+	if (vote == 0) {
+		m_Votes = 0;
+		m_Status = isMostlyCapped ? "Holding, most of the view is at the cap" : "Holding";
+		return iterations;
+	}
+
+	// a raise waits for a time drawn with the current cap, or for none to come
+	if (vote > 0 && m_UpdatesSinceChange < c_SettleUpdates) {
+		m_Status = "Waiting for the frame time";
+		return iterations;
+	}
+
+	m_Votes = (vote > 0) == (m_Votes > 0) ? m_Votes + vote : vote;
+	if (std::abs(m_Votes) < c_AgreeingSamples)
+		return iterations;
+	m_Votes = 0;
+
+	int next = iterations;
+	if (vote > 0) {
+		// frame time grows with the cap at most in proportion, so this raise stays under the ceiling
+		float factor = c_RaiseFactor;
+		if (m_FrameMilliseconds > 0.0)
+			factor = std::min(factor, static_cast<float>(m_CeilingMilliseconds / m_FrameMilliseconds));
+		if (factor < c_MinRaiseFactor) {
+			m_Status = "Held by the frame time ceiling";
+			return iterations;
+		}
+		next = std::min(c_MaxIterations, static_cast<int>(iterations * factor));
+		m_Status = "Raising, pixels escape just below the cap";
+	}
+	else {
+		next = std::max(floor, static_cast<int>(iterations * c_LowerFactor));
+		m_Status = isOverCeiling ? "Lowering to meet the frame time ceiling" : "Lowering, nothing escapes near the cap";
+		if (next == iterations)
+			m_Status = "At the floor for this zoom";
+	}
+
+	return ChangeTo(iterations, next);
+}
+
+void IterationController::AddFrameTime(double milliseconds)
+{
+	// until the new cap's own times arrive, the scaled estimate is the better guess
+	if (m_UpdatesSinceChange >= c_SettleUpdates)
+		m_FrameMilliseconds = milliseconds;
+}
+
+int IterationController::ChangeTo(int iterations, int next)
+{
+	if (next == iterations)
+		return next;
+
+	// frame time grows with the cap at most in proportion, so the scaled time
+	// is an upper bound that keeps the next raise under the ceiling too
+	m_FrameMilliseconds = iterations > 0 ? m_FrameMilliseconds * next / iterations : 0.0;
+	m_UpdatesSinceChange = 0;
+	return next;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <core/FractalParams.h>
+#include <renderer/IterationHistogram.h>
+
+// how a frame's pixels escaped, from the GPU histogram or a CPU sample
+struct EscapeStats {
+	// the cap the pixels were iterated to, 0 when there is nothing to go on
+	int iterations = 0;
+	float capFraction = 0.0f;
+	// escaped in the top c_NearCapShare of the range, the ones a lower cap would lose
+	float nearCapFraction = 0.0f;
+};
+
+// Picks the iteration cap for the 2D fractals. The cap hit fraction on its own
+// can not tell false interior from the real set, so the controller looks at
+// the pixels that only just escaped instead: many of them means more are still
+// stuck at the cap and it should go up, almost none means iterations are being
+// spent on nothing and it can come down, unless most of the view sits at the
+// cap, where the two look the same. Changes need several measurements in
+// a row to agree, and the gap between the two thresholds keeps it from
+// hunting. The zoom depth sets a floor, and raising stops at the frame time
+// ceiling. After a change the last frame time is scaled to the new cap and
+// stands in until times drawn with it come back.
+class IterationController {
+public:
+	static constexpr int c_MinIterations = 50;
+	static constexpr int c_MaxIterations = 100000;
+
+	static constexpr float c_NearCapShare = 0.125f;
+	static constexpr float c_RaiseAbove = 0.002f;
+	static constexpr float c_LowerBelow = 0.0002f;
+	// past this share of pixels at the cap, nothing escaping near it is no reason to lower
+	static constexpr float c_HoldCapAbove = 0.5f;
+	static constexpr float c_RaiseFactor = 1.5f;
+	static constexpr float c_LowerFactor = 0.8f;
+	static constexpr int c_AgreeingSamples = 3;
+	// GPU times come back a few frames late, ones this soon after a change are for the old cap
+	static constexpr int c_SettleUpdates = 8;
+
+	// grid of the CPU sample used when there is no histogram
+	static constexpr int c_SampleColumns = 64;
+	static constexpr int c_SampleRows = 36;
+	// iterations the CPU sample may spend in one frame, a few milliseconds;
+	// at high caps a grid takes many frames
+	static constexpr long long c_SampleBudget = 500000;
+
+	// typical cap for a zoom depth; half of it is the floor
+	static int EstimateForZoom(float zoom);
+
+	static EscapeStats FromHistogram(const IterationHistogram& histogram);
+	// iterates the next part of a coarse grid of the view on the CPU, for the
+	// fragment path; true once the grid is done, with stats filled in
+	bool SampleCpu(const FractalParams& params, EscapeStats& stats);
+	// drops a part done grid, when the view it was for has changed
+	void RestartSample();
+
+	// new cap given the current one; stats counted with another cap are ignored
+	int Update(int iterations, float zoom, const EscapeStats& stats);
+
+	// GPU time of a fractal pass drawn at full quality
+	void AddFrameTime(double milliseconds);
+
+	float GetCeilingMilliseconds() const { return m_CeilingMilliseconds; }
+	void SetCeilingMilliseconds(float milliseconds) { m_CeilingMilliseconds = milliseconds; }
+
+	// what the last update decided, for the UI
+	const char* GetStatus() const { return m_Status; }
+
+private:
+	// returns next, carrying the frame time over to it
+	int ChangeTo(int iterations, int next);
+
+	float m_CeilingMilliseconds = 50.0f;
+	double m_FrameMilliseconds = 0.0;
+	int m_UpdatesSinceChange = c_SettleUpdates;
+
+	// progress through the CPU sample grid, and the cap it is counting to
+	int m_SampleNext = 0;
+	int m_SampleIterations = 0;
+	int m_SampleCapped = 0;
+	int m_SampleNear = 0;
+
+	// positive while samples ask for more, negative while they ask for fewer
+	int m_Votes = 0;
+	const char* m_Status = "Waiting for a measurement";
+};
@@ -0,0 +1,99 @@
+#include "IterationHistogram.h"
+#include <renderer/GL43.h>
+#include <renderer/GLState.h>
+
+static const uint32_t c_Zeros[IterationHistogram::c_NumBins + 1] = {};
+
+IterationHistogram::IterationHistogram()
+{
+	for (Frame& frame : m_Frames) {
+		glGenBuffers(1, &frame.buffer);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, frame.buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(c_Zeros), c_Zeros, GL_DYNAMIC_READ);
+	}
+
+	glGenBuffers(1, &m_Scratch);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_Scratch);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(c_Zeros), c_Zeros, GL_DYNAMIC_COPY);
+}
+
+IterationHistogram::~IterationHistogram()
+{
+	for (Frame& frame : m_Frames) {
+		if (frame.fence)
+			glDeleteSync(frame.fence);
+		GLState::ForgetBuffer(frame.buffer);
+		glDeleteBuffers(1, &frame.buffer);
+	}
+	GLState::ForgetBuffer(m_Scratch);
+	glDeleteBuffers(1, &m_Scratch);
+}
+
+void IterationHistogram::Begin(int iterations)
+{
+	Poll();
+
+	// still in flight from c_NumBuffers frames ago, count this frame into nothing
+	Frame& frame = m_Frames[m_Next];
+	if (frame.fence) {
+		m_Current = -1;
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, c_Binding, m_Scratch);
+		return;
+	}
+
+	frame.iterations = iterations;
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, frame.buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(c_Zeros), c_Zeros);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, c_Binding, frame.buffer);
+	m_Current = m_Next;
+}
+
+void IterationHistogram::End()
+{
+	if (m_Current < 0)
+		return;
+
+	m_Frames[m_Current].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_Next = (m_Next + 1) % c_NumBuffers;
+	m_Current = -1;
+}
+
+bool IterationHistogram::Poll()
+{
+	// frames finish in the order they were issued, so walk from the oldest;
+	// older finished frames are only freed, the newest is the one read back
+	Frame* newest = nullptr;
+	for (int i = 0; i < c_NumBuffers; i++) {
+		Frame& frame = m_Frames[(m_Next + i) % c_NumBuffers];
+		if (!frame.fence)
+			continue;
+
+		GLenum status = glClientWaitSync(frame.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync(frame.fence);
+		frame.fence = nullptr;
+		newest = &frame;
+	}
+
+	if (!newest)
+		return false;
+
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, newest->buffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_Bins), m_Bins);
+	m_Iterations = newest->iterations;
+
+	m_Pixels = 0;
+	for (uint32_t count : m_Bins)
+		m_Pixels += count;
+
+	double binWidth = static_cast<double>(m_Iterations) / c_NumBins;
+	m_TotalIterations = static_cast<double>(m_Bins[c_NumBins]) * m_Iterations;
+	for (int i = 0; i <= c_NumBins; i++) {
+		m_Fractions[i] = m_Pixels > 0 ? static_cast<float>(m_Bins[i]) / m_Pixels : 0.0f;
+		if (i < c_NumBins)
+			m_TotalIterations += m_Bins[i] * (i + 0.5) * binWidth;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// Escape iteration counts of a frame, binned by the compute kernels into a
+// shader storage buffer. Buffers are used in turn and each frame's is fenced,
+// so results are read a few frames later once the GPU is done with them,
+// never waiting on it. The bins split [0, iterations) evenly, with one more
+// slot for the pixels that hit the iteration cap.
+class IterationHistogram {
+public:
+	static constexpr int c_NumBins = 64;
+	static constexpr int c_NumBuffers = 3;
+	// storage buffer binding the kernels write to
+	static constexpr unsigned int c_Binding = 4;
+
+	IterationHistogram();
+	~IterationHistogram();
+
+	// zeroes a free buffer and binds it for this frame's dispatches
+	void Begin(int iterations);
+	// fences the frame's buffer, after the last dispatch that writes to it
+	void End();
+
+	// takes in the newest finished frame, true when one arrived
+	bool Poll();
+
+	// c_NumBins + 1 counts, the last one is the pixels that hit the cap
+	const uint32_t* GetBins() const { return m_Bins; }
+	// the same as fractions of all pixels, for plotting
+	const float* GetFractions() const { return m_Fractions; }
+	float GetCapFraction() const { return m_Fractions[c_NumBins]; }
+	uint64_t GetPixels() const { return m_Pixels; }
+	// the iteration limit the bins were counted with
+	int GetIterations() const { return m_Iterations; }
+	// every pixel's iterations added up, taking each bin at its centre
+	double GetTotalIterations() const { return m_TotalIterations; }
+	bool HasResult() const { return m_Pixels > 0; }
+
+private:
+	struct Frame {
+		unsigned int buffer = 0;
+		GLsync fence = nullptr;
+		int iterations = 0;
+	};
+
+	Frame m_Frames[c_NumBuffers];
+	// bound on frames where every buffer is still in flight, never read
+	unsigned int m_Scratch = 0;
+	int m_Next = 0;
+	// the frame between Begin and End, -1 when it went to the scratch buffer
+	int m_Current = -1;
+
+	uint32_t m_Bins[c_NumBins + 1] = {};
+	float m_Fractions[c_NumBins + 1] = {};
+	uint64_t m_Pixels = 0;
+	int m_Iterations = 0;
+	double m_TotalIterations = 0.0;
+};
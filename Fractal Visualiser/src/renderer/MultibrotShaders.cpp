@@ -0,0 +1,65 @@
+#include "MultibrotShaders.h"
+
+#include <core/AllocationCounter.h>
+#include <core/FractalParams.h>
+#include <core/Trace.h>
+
+namespace {
+	const char* c_ShaderPath = "res/shaders/multibrot.shader";
+}
+
+MultibrotShaders::MultibrotShaders(const std::string& defines) : m_Defines(defines)
+{
+	for (int i = 0; i < 2; i++)
+		m_Polar[i] = std::make_unique<Shader>(c_ShaderPath, GetDefines(i == 1, 0));
+}
+
+Shader& MultibrotShaders::Get(int fractal, float power)
+{
+	int conjugate = fractal == FRACTAL_MULTICORN ? 1 : 0;
+	int chainPower = ComplexPower::GetChainPower(power);
+	if (chainPower == 0)
+		return *m_Polar[conjugate];
+
+	std::unique_ptr<Shader>& chain = m_Chains[conjugate][chainPower];
+	if (!chain) {
+		// a new power is a one-off compile, much like picking another fractal
+		TRACE_SCOPE("MultibrotShaders::Compile");
+		AllocationCounter::Exempt exempt;
+		chain = std::make_unique<Shader>(c_ShaderPath, GetDefines(conjugate == 1, chainPower));
+	}
+	return *chain;
+}
+
+std::string MultibrotShaders::GenerateChain(int n)
+{
+	// the same walk as ComplexPower::Chain: from n's top digit down, square,
+	// then multiply z back in where the digit is set; zk holds z^k
+	std::string source = "vec2 powerChain(vec2 z1)\n{\n";
+	int top = 1 << ComplexPower::CountSquarings(n);
+	int k = 1;
+	for (int digit = top >> 1; digit > 0; digit >>= 1) {
+		std::string from = "z" + std::to_string(k);
+		k *= 2;
+		source += "    vec2 z" + std::to_string(k) + " = vec2(" + from + ".x * " + from + ".x - " + from + ".y * " + from + ".y, 2.0 * "
+			+ from + ".x * " + from + ".y);\n";
+		if (n & digit) {
+			std::string squared = "z" + std::to_string(k);
+			k++;
+			source += "    vec2 z" + std::to_string(k) + " = vec2(" + squared + ".x * z1.x - " + squared + ".y * z1.y, " + squared + ".x * z1.y + "
+				+ squared + ".y * z1.x);\n";
+		}
+	}
+	source += "    return z" + std::to_string(k) + ";\n}\n";
+	return source;
+}
+
+std::string MultibrotShaders::GetDefines(bool isConjugate, int chainPower) const
+{
+	std::string defines = m_Defines;
+	if (isConjugate)
+		defines += "#define MULTICORN\n";
+	if (chainPower > 0)
+		defines += "#define POWER_CHAIN\n" + GenerateChain(chainPower);
+	return defines;
+}
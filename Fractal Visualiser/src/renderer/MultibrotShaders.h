@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cpu/ComplexPower.h>
+#include <shader/Shader.h>
+
+// Variants of multibrot.shader for the Multibrot and Multicorn. Each whole
+// power up to ComplexPower::c_MaxChainPower gets a program of its own with
+// z^n written out as its repeated squaring chain, compiled the first time the
+// power is shown; other powers share one program per formula that takes the
+// power as a uniform and goes through polar form.
+class MultibrotShaders {
+public:
+	// compiles the two polar programs, the chains wait until they are asked for;
+	// defines go ahead of every variant, as Shader takes them
+	explicit MultibrotShaders(const std::string& defines = "");
+
+	// the program for the Multibrot or Multicorn at power
+	Shader& Get(int fractal, float power);
+
+	// powerChain(z) for z^n, as GLSL to go ahead of the shader
+	static std::string GenerateChain(int n);
+
+private:
+	std::string GetDefines(bool isConjugate, int chainPower) const;
+
+	std::string m_Defines;
+	// [0] is the Multibrot, [1] the Multicorn
+	std::unique_ptr<Shader> m_Polar[2];
+	std::unique_ptr<Shader> m_Chains[2][ComplexPower::c_MaxChainPower + 1];
+};
@@ -0,0 +1,68 @@
+#include "QualityController.h"
+#include <algorithm>
+#include <cmath>
+
+const char* const QualityController::c_TierNames[c_NumTiers] = { "Interactive", "Preview", "Final" };
+
+// the preview tier is what the shader used to hard code
+static constexpr QualityBudget c_TierBudgets[QualityController::c_NumTiers] = {
+	{ 64, 24, 0.001f, 1.0f, 1.0f },
+	{ 100, 64, 0.0005f, 1.0f, 1.0f },
+	{ 200, 128, 0.00025f, 1.0f, 1.0f }
+};
+
+QualityController::QualityController() : m_Budget(c_TierBudgets[static_cast<int>(QualityTier::Preview)])
+{
+}
+
+void QualityController::AddMeasurement(double milliseconds, QualityTier tier)
+{
+	if (tier != QualityTier::Interactive)
+		return;
+
+	m_GpuMilliseconds = milliseconds;
+	Tune(milliseconds);
+}
+
+void QualityController::Update(bool viewChanged, double now)
+{
+	if (viewChanged)
+		m_LastChange = now;
+
+	if (!m_isAuto)
+		m_Tier = m_ForcedTier;
+	else if (viewChanged)
+		m_Tier = QualityTier::Interactive;
+	else if (now - m_LastChange < c_FinalDelay)
+		m_Tier = QualityTier::Preview;
+	else
+		m_Tier = QualityTier::Final;
+
+	m_Budget = c_TierBudgets[static_cast<int>(m_Tier)];
+	if (m_Tier == QualityTier::Interactive) {
+		m_Budget.resolutionScale = m_ResolutionScale;
+		m_Budget.iterationScale = m_IterationScale;
+	}
+}
+
+void QualityController::Tune(double milliseconds)
+{
+	// cost goes with the pixel count, so the side scales by the square root.
+	// Capped per frame so one odd measurement cannot swing it far.
+	float ratio = static_cast<float>(m_TargetMilliseconds / std::max(milliseconds, 0.1));
+	float step = std::min(std::max(std::sqrt(ratio), 0.8f), 1.25f);
+
+	if (ratio < 1.0f) {
+		if (m_ResolutionScale > c_MinResolutionScale)
+			m_ResolutionScale = std::max(m_ResolutionScale * step, c_MinResolutionScale);
+		else
+			m_IterationScale = std::max(m_IterationScale * step * step, c_MinIterationScale);
+	}
+	// some headroom before giving quality back, so it does not flicker at the target
+	else if (ratio > 1.2f) {
+		if (m_IterationScale < 1.0f)
+			m_IterationScale = std::min(m_IterationScale * step * step, 1.0f);
+		else
+			m_ResolutionScale = std::min(m_ResolutionScale * step, 1.0f);
+	}
+}
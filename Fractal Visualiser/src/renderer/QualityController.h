@@ -0,0 +1,74 @@
+#pragma once
+
+enum class QualityTier {
+	Interactive = 0,
+	Preview = 1,
+	Final = 2
+};
+
+// what a frame may spend: march and shadow steps and the surface distance for
+// the Mandelbulb, a share of the iteration slider for the 2D fractals, and the
+// fraction of the window's width and height rendered before scaling up
+struct QualityBudget {
+	int maxSteps;
+	int maxShadowSteps;
+	float surfaceDist;
+	float iterationScale;
+	float resolutionScale;
+};
+
+// Picks a quality tier each frame. While the view is changing the interactive
+// tier is used, and its resolution and iteration share are tuned from measured
+// GPU frame times to hold the target: resolution goes first, iterations only
+// once it is at its floor, and they come back in the opposite order. Once the
+// view settles, a preview frame at full size is drawn, then final quality
+// after a short pause, which is also when accumulation gets to run.
+class QualityController {
+public:
+	static constexpr int c_NumTiers = 3;
+	static const char* const c_TierNames[c_NumTiers];
+
+	// seconds without a change before the final tier
+	static constexpr double c_FinalDelay = 0.5;
+	static constexpr float c_MinResolutionScale = 0.25f;
+	static constexpr float c_MinIterationScale = 0.25f;
+
+	QualityController();
+
+	// call once a frame before rendering, now in seconds
+	void Update(bool viewChanged, double now);
+
+	// GPU time of an earlier frame and the tier it was drawn at, only
+	// interactive frames steer the budget
+	void AddMeasurement(double milliseconds, QualityTier tier);
+
+	QualityTier GetTier() const { return m_Tier; }
+	const QualityBudget& GetBudget() const { return m_Budget; }
+
+	// with auto off the forced tier is used throughout
+	bool IsAuto() const { return m_isAuto; }
+	void SetAuto(bool isAuto) { m_isAuto = isAuto; }
+	void SetForcedTier(QualityTier tier) { m_ForcedTier = tier; }
+
+	float GetTargetMilliseconds() const { return m_TargetMilliseconds; }
+	void SetTargetMilliseconds(float milliseconds) { m_TargetMilliseconds = milliseconds; }
+
+	// last interactive frame as measured on the GPU
+	double GetGpuMilliseconds() const { return m_GpuMilliseconds; }
+
+private:
+	void Tune(double milliseconds);
+
+	bool m_isAuto = true;
+	QualityTier m_ForcedTier = QualityTier::Preview;
+	QualityTier m_Tier = QualityTier::Preview;
+	QualityBudget m_Budget;
+
+	float m_TargetMilliseconds = 16.7f;
+	double m_GpuMilliseconds = 0.0;
+	double m_LastChange = -1.0;
+
+	// tuned share of the interactive tier, kept between interactions
+	float m_ResolutionScale = 1.0f;
+	float m_IterationScale = 1.0f;
+};
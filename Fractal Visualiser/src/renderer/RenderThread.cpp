@@ -0,0 +1,290 @@
+#include "RenderThread.h"
+
+#include <chrono>
+
+#include <core/Trace.h>
+#include <core/Window.h>
+#include <renderer/AccumulationBuffer.h>
+#include <renderer/DistanceVolume.h>
+#include <renderer/GL43.h>
+#include <renderer/GLState.h>
+#include <vertex/VertexBufferLayout.h>
+
+namespace {
+	const float c_QuadVertices[] = { 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f };
+	const unsigned int c_QuadIndices[] = { 0, 1, 3, 1, 2, 3 };
+
+	const char* c_ShaderPaths[FRACTAL_MANDELBULB + 1] = {
+		"res/shaders/mandelbrot.shader", "res/shaders/burningship.shader", "res/shaders/tricorn.shader", "res/shaders/mandelbulb.shader"
+	};
+
+	// how long the render thread waits on its own frame before handing it over
+	// regardless; the main thread's wait on the fence still keeps it correct
+	const GLuint64 c_FenceTimeout = 1000000000;
+	// the main thread submits every frame, so the wait for a new snapshot is short
+	const std::chrono::milliseconds c_IdleWait(1);
+}
+
+RenderThread::RenderThread()
+{
+	p_Context = Window::CreateSharedContext();
+	if (!p_Context)
+		return;
+
+	m_Thread = std::thread(&RenderThread::Run, this);
+}
+
+RenderThread::~RenderThread()
+{
+	if (!p_Context)
+		return;
+
+	m_isStopping = true;
+	m_Thread.join();
+
+	// the render thread has let go of its context, what is left is shared or the main thread's
+	for (Slot& slot : m_Slots) {
+		if (slot.readFramebuffer) {
+			GLState::ForgetFramebuffer(slot.readFramebuffer);
+			glDeleteFramebuffers(1, &slot.readFramebuffer);
+		}
+		if (slot.drawn)
+			glDeleteSync(slot.drawn);
+		if (slot.read)
+			glDeleteSync(slot.read);
+	}
+	glfwDestroyWindow(p_Context);
+}
+
+void RenderThread::Submit(const RenderSnapshot& snapshot)
+{
+	m_Snapshot.Store(snapshot);
+}
+
+bool RenderThread::Present(int windowWidth, int windowHeight)
+{
+	TRACE_SCOPE("RenderThread::Present");
+
+	m_HasLatest = false;
+	if (m_Ready.load(std::memory_order_acquire) & c_NewFrame) {
+		m_Showing = m_Ready.exchange(m_Showing) & c_SlotMask;
+
+		Slot& slot = m_Slots[m_Showing];
+		if (slot.drawn) {
+			glWaitSync(slot.drawn, 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(slot.drawn);
+			slot.drawn = nullptr;
+		}
+		m_HasFrame = true;
+		m_HasLatest = true;
+		m_LatestMilliseconds = slot.milliseconds;
+		m_LatestTier = slot.tier;
+	}
+	if (!m_HasFrame)
+		return false;
+
+	// framebuffers are not shared between contexts, so this side wraps the texture in one of its own
+	Slot& slot = m_Slots[m_Showing];
+	if (!slot.readFramebuffer)
+		glGenFramebuffers(1, &slot.readFramebuffer);
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, slot.readFramebuffer);
+
+	// a resize gives the texture new storage in the render thread's context,
+	// which this context's framebuffer is only sure to see once it attaches again
+	if (slot.width != slot.attachedWidth || slot.height != slot.attachedHeight) {
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, slot.target->GetColorAttachment().GetID(), 0);
+		slot.attachedWidth = slot.width;
+		slot.attachedHeight = slot.height;
+	}
+
+	bool isComplete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (isComplete) {
+		Framebuffer::BindDefault(windowWidth, windowHeight);
+		GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, slot.readFramebuffer);
+		glBlitFramebuffer(0, 0, slot.width, slot.height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	}
+	GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	// the render thread waits on this before it draws over the slot; flushed so that wait can end
+	if (slot.read)
+		glDeleteSync(slot.read);
+	slot.read = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	return isComplete;
+}
+
+bool RenderThread::GetLatest(double& milliseconds, int& tier) const
+{
+	milliseconds = m_LatestMilliseconds;
+	tier = m_LatestTier;
+	return m_HasLatest;
+}
+
+void RenderThread::Run()
+{
+	Trace::SetThreadName("Render");
+	glfwMakeContextCurrent(p_Context);
+	CreateResources();
+
+	RenderSnapshot snapshot;
+	while (!m_isStopping) {
+		if (!m_Snapshot.Take(snapshot)) {
+			std::this_thread::sleep_for(c_IdleWait);
+			continue;
+		}
+		Draw(snapshot);
+	}
+
+	// objects made in this context go while it is still current
+	DestroyResources();
+	glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThread::CreateResources()
+{
+	TRACE_SCOPE("RenderThread::CreateResources");
+
+	m_QuadVertices = std::make_unique<VertexBuffer>(c_QuadVertices, static_cast<unsigned int>(sizeof(c_QuadVertices)));
+	m_QuadIndices = std::make_unique<IndexBuffer>(c_QuadIndices, static_cast<unsigned int>(sizeof(c_QuadIndices)));
+
+	VertexBufferLayout layout;
+	layout.AddAttribute<float>(2);
+	m_Quad = std::make_unique<VertexArray>();
+	m_Quad->AddBuffer(*m_QuadVertices, layout);
+	m_Quad->Bind();
+	m_QuadIndices->Bind();
+
+	for (int i = 0; i <= FRACTAL_MANDELBULB; i++)
+		m_Shaders[i] = std::make_unique<Shader>(c_ShaderPaths[i]);
+	m_MultibrotShaders = std::make_unique<MultibrotShaders>();
+	m_NewtonShader = std::make_unique<Shader>("res/shaders/newton.shader");
+
+	// the bulb's unused samplers still need units of their own to validate
+	Shader& bulb = *m_Shaders[FRACTAL_MANDELBULB];
+	bulb.Bind();
+	glUniform1i(bulb.GetLocation("distanceVolume"), DistanceVolume::c_TextureUnit);
+	glUniform1i(bulb.GetLocation("history"), AccumulationBuffer::c_TextureUnit);
+	glUniform1i(bulb.GetLocation("useVolume"), 0);
+	glUniform1i(bulb.GetLocation("accumulate"), 0);
+
+	if (GL43::IsLoaded())
+		m_ComputeRenderer = std::make_unique<ComputeRenderer>();
+	m_ConePrepass = std::make_unique<ConePrepass>();
+
+	for (Slot& slot : m_Slots)
+		slot.target = std::make_unique<Framebuffer>(1, 1, GL_RGBA8);
+}
+
+void RenderThread::DestroyResources()
+{
+	for (Slot& slot : m_Slots)
+		slot.target.reset();
+
+	m_ConePrepass.reset();
+	m_ComputeRenderer.reset();
+	for (std::unique_ptr<Shader>& shader : m_Shaders)
+		shader.reset();
+	m_MultibrotShaders.reset();
+	m_NewtonShader.reset();
+	m_Quad.reset();
+	m_QuadIndices.reset();
+	m_QuadVertices.reset();
+}
+
+void RenderThread::BindFragmentShader(const RenderSnapshot& snapshot)
+{
+	const FractalParams& params = snapshot.params;
+	bool isMultibrot = params.fractal == FRACTAL_MULTIBROT || params.fractal == FRACTAL_MULTICORN;
+	Shader& shader = isMultibrot ? m_MultibrotShaders->Get(params.fractal, params.power)
+		: params.fractal == FRACTAL_NEWTON ? *m_NewtonShader : *m_Shaders[params.fractal];
+
+	shader.Bind();
+	glUniform2i(shader.GetLocation("resolution"), params.width, params.height);
+	glUniform2f(shader.GetLocation("location"), params.location.x, params.location.y);
+	glUniform2f(shader.GetLocation("mousePos"), params.juliaConstant.x, params.juliaConstant.y);
+	glUniform1i(shader.GetLocation("juliaMode"), params.juliaMode);
+	glUniform1f(shader.GetLocation("zoom"), params.zoom);
+	glUniform1i(shader.GetLocation("iterations"), params.iterations);
+	glUniform1f(shader.GetLocation("exponent"), params.power);
+	glUniform3fv(shader.GetLocation("color_1"), 1, params.colors[0]);
+	glUniform3fv(shader.GetLocation("color_2"), 1, params.colors[1]);
+	glUniform3fv(shader.GetLocation("color_3"), 1, params.colors[2]);
+	glUniform3fv(shader.GetLocation("color_4"), 1, params.colors[3]);
+
+	if (params.fractal == FRACTAL_NEWTON) {
+		const NewtonPolynomial& polynomial = params.newton;
+		glUniform1i(shader.GetLocation("degree"), polynomial.degree);
+		glUniform2fv(shader.GetLocation("coefficients"), NewtonPolynomial::c_MaxDegree + 1, &polynomial.coefficients[0].x);
+		glUniform1i(shader.GetLocation("rootCount"), polynomial.rootCount);
+		glUniform2fv(shader.GetLocation("roots"), NewtonPolynomial::c_MaxDegree, &polynomial.roots[0].x);
+	}
+
+	if (params.fractal == FRACTAL_MANDELBULB) {
+		glUniform1f(shader.GetLocation("power"), snapshot.power);
+		glUniform1i(shader.GetLocation("maxSteps"), snapshot.maxSteps);
+		glUniform1i(shader.GetLocation("maxShadowSteps"), snapshot.maxShadowSteps);
+		glUniform1f(shader.GetLocation("surfaceDist"), snapshot.surfaceDist);
+		glUniform1i(shader.GetLocation("showSteps"), snapshot.showSteps);
+		glUniform1i(shader.GetLocation("trapColoring"), snapshot.trapColoring);
+		glUniform1i(shader.GetLocation("coneBlock"), snapshot.coneBlockSize);
+	}
+}
+
+void RenderThread::Draw(const RenderSnapshot& snapshot)
+{
+	TRACE_SCOPE("RenderThread::Draw");
+	GLState::BeginFrame();
+	auto start = std::chrono::steady_clock::now();
+
+	// the slot may still be on screen in the main context, or hold a frame that was never shown
+	Slot& slot = m_Slots[m_Drawing];
+	if (slot.read) {
+		glWaitSync(slot.read, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(slot.read);
+		slot.read = nullptr;
+	}
+	if (slot.drawn) {
+		glDeleteSync(slot.drawn);
+		slot.drawn = nullptr;
+	}
+
+	const FractalParams& params = snapshot.params;
+	slot.target->Resize(params.width, params.height);
+
+	// as the main thread draws it, less the passes that keep state between frames
+	if (params.fractal == FRACTAL_MANDELBULB) {
+		if (snapshot.coneBlockSize > 0 && m_ConePrepass->IsValid()) {
+			m_ConePrepass->SetBlockSize(snapshot.coneBlockSize);
+			m_ConePrepass->Render(params, snapshot.power, *m_Quad);
+			m_ConePrepass->GetDepth().Bind(0);
+		}
+		slot.target->Bind();
+		BindFragmentShader(snapshot);
+		m_Quad->Bind();
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	}
+	else if (snapshot.useCompute && m_ComputeRenderer && m_ComputeRenderer->IsValid()) {
+		slot.target->Bind();
+		m_ComputeRenderer->SetPersistentGroups(snapshot.persistentGroups);
+		m_ComputeRenderer->SetChunkSize(snapshot.chunkSize);
+		m_ComputeRenderer->Render(params, *m_Quad);
+	}
+	else {
+		slot.target->Bind();
+		BindFragmentShader(snapshot);
+		m_Quad->Bind();
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	}
+
+	// waiting here keeps this thread at most a frame ahead of the GPU, and the
+	// time to the fence is the frame's cost on this context
+	slot.drawn = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glClientWaitSync(slot.drawn, GL_SYNC_FLUSH_COMMANDS_BIT, c_FenceTimeout);
+
+	slot.width = params.width;
+	slot.height = params.height;
+	slot.tier = snapshot.tier;
+	slot.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	m_Drawing = m_Ready.exchange(m_Drawing | c_NewFrame) & c_SlotMask;
+}
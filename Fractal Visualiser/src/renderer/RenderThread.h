@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <core/FractalParams.h>
+#include <core/LatestValue.h>
+#include <renderer/ComputeRenderer.h>
+#include <renderer/ConePrepass.h>
+#include <renderer/Framebuffer.h>
+#include <renderer/MultibrotShaders.h>
+#include <shader/Shader.h>
+#include <vertex/IndexBuffer.h>
+#include <vertex/VertexArray.h>
+#include <vertex/VertexBuffer.h>
+
+// Everything the render thread needs for one frame, copied out on the main
+// thread so the render thread never reads the Application.
+struct RenderSnapshot {
+	// already scaled by the quality budget
+	FractalParams params;
+	// the QualityTier the budget came from, handed back with the frame's time
+	int tier = 0;
+
+	// Mandelbulb
+	float power = 8.0f;
+	int maxSteps = 100;
+	int maxShadowSteps = 64;
+	float surfaceDist = 0.0005f;
+	bool showSteps = false;
+	bool trapColoring = false;
+	// 0 skips the cone pre-pass
+	int coneBlockSize = 8;
+
+	// compute backend for the 2D fractals
+	bool useCompute = false;
+	int persistentGroups = 128;
+	int chunkSize = 0;
+};
+
+// Draws the fractal on a thread of its own, with a hidden context that shares
+// objects with the window's, so a slow fractal frame holds up neither event
+// handling nor ImGui. The main thread submits a snapshot every frame through a
+// lock-free latest value, and the render thread draws the newest one there.
+//
+// Finished frames go round three shared textures: the render thread draws one
+// while the main thread shows another, and the third holds the newest finished
+// frame. Slots change hands through one atomic exchange each way, and a fence
+// goes with each hand-over so neither context touches a texture the other is
+// still using.
+//
+// The accumulation buffer, baked distance volume and iteration histogram belong
+// to the main thread's renderers and are not used here.
+class RenderThread {
+public:
+	static constexpr int c_NumSlots = 3;
+
+	// creates the shared context and starts the thread; main thread only
+	RenderThread();
+	// waits for the frame in progress
+	~RenderThread();
+
+	// false when the shared context could not be created
+	bool IsValid() const { return p_Context != nullptr; }
+
+	// hands over the next frame; if the render thread is behind, it replaces
+	// the snapshot the render thread has not taken yet
+	void Submit(const RenderSnapshot& snapshot);
+
+	// picks up the newest finished frame and scales it over the window's
+	// framebuffer; false until the first frame has finished
+	bool Present(int windowWidth, int windowHeight);
+
+	// wall time of the frame the last Present picked up, from its first GL call
+	// to its fence, and the tier it was drawn at; false if none was new
+	bool GetLatest(double& milliseconds, int& tier) const;
+
+private:
+	static constexpr int c_SlotMask = 3;
+	// set in m_Ready while the frame there has not been picked up
+	static constexpr int c_NewFrame = 4;
+
+	struct Slot {
+		// created on the render thread; only the texture is shared
+		std::unique_ptr<Framebuffer> target;
+		// the main thread's framebuffer around the same texture, to blit from,
+		// and the size the texture had when it was last attached there
+		unsigned int readFramebuffer = 0;
+		int attachedWidth = 0;
+		int attachedHeight = 0;
+		// set once drawn, waited on by the main thread before it reads
+		GLsync drawn = nullptr;
+		// set once read, waited on by the render thread before it draws again
+		GLsync read = nullptr;
+
+		int width = 0;
+		int height = 0;
+		int tier = 0;
+		double milliseconds = 0.0;
+	};
+
+	void Run();
+	void CreateResources();
+	void DestroyResources();
+	void Draw(const RenderSnapshot& snapshot);
+	void BindFragmentShader(const RenderSnapshot& snapshot);
+
+	GLFWwindow* p_Context = nullptr;
+	std::thread m_Thread;
+	std::atomic<bool> m_isStopping{ false };
+	LatestValue<RenderSnapshot> m_Snapshot;
+
+	Slot m_Slots[c_NumSlots];
+	// slot with the newest finished frame, swapped with m_Drawing by the render
+	// thread and with m_Showing by the main thread
+	std::atomic<int> m_Ready{ 1 };
+	// render thread only
+	int m_Drawing = 0;
+	// main thread only
+	int m_Showing = 2;
+	bool m_HasFrame = false;
+	bool m_HasLatest = false;
+	double m_LatestMilliseconds = 0.0;
+	int m_LatestTier = 0;
+
+	// created and destroyed on the render thread, in its context
+	std::unique_ptr<VertexBuffer> m_QuadVertices;
+	std::unique_ptr<IndexBuffer> m_QuadIndices;
+	std::unique_ptr<VertexArray> m_Quad;
+	// fragment shaders in FractalType order
+	std::unique_ptr<Shader> m_Shaders[FRACTAL_MANDELBULB + 1];
+	std::unique_ptr<MultibrotShaders> m_MultibrotShaders;
+	std::unique_ptr<Shader> m_NewtonShader;
+	std::unique_ptr<ComputeRenderer> m_ComputeRenderer;
+	std::unique_ptr<ConePrepass> m_ConePrepass;
+};
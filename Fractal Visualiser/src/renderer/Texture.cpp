@@ -0,0 +1,74 @@
+#include "Texture.h"
+#include <glad/glad.h>
+
+Texture::Texture(int width, int height, unsigned int internalFormat) : m_InternalFormat(internalFormat), m_Width(0), m_Height(0)
+{
+	glGenTextures(1, &m_ID);
+	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	Resize(width, height);
+}
+
+Texture::~Texture()
+{
+	glDeleteTextures(1, &m_ID);
+}
+
+void Texture::Bind(unsigned int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, m_ID);
+}
+
+void Texture::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glTexImage2D(GL_TEXTURE_2D, 0, m_InternalFormat, width, height, 0, GetFormat(m_InternalFormat), GetType(m_InternalFormat), nullptr);
+}
+
+void Texture::Upload(const void* pixels) const
+{
+	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GetFormat(m_InternalFormat), GetType(m_InternalFormat), pixels);
+}
+
+unsigned int Texture::GetFormat(unsigned int internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R32F:
+	case GL_R16F:
+		return GL_RED;
+	case GL_R32UI:
+		return GL_RED_INTEGER;
+	case GL_RG32F:
+		return GL_RG;
+	case GL_RGB8:
+		return GL_RGB;
+	}
+	return GL_RGBA;
+}
+
+unsigned int Texture::GetType(unsigned int internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R32F:
+	case GL_R16F:
+	case GL_RG32F:
+	case GL_RGBA16F:
+	case GL_RGBA32F:
+		return GL_FLOAT;
+	case GL_R32UI:
+		return GL_UNSIGNED_INT;
+	}
+	return GL_UNSIGNED_BYTE;
+}
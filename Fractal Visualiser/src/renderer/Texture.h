@@ -0,0 +1,28 @@
+#pragma once
+
+// Single level 2D texture with nearest filtering, used as a render target and as
+// an image for compute shaders.
+class Texture {
+public:
+	Texture(int width, int height, unsigned int internalFormat);
+	~Texture();
+
+	void Bind(unsigned int unit) const;
+	void Resize(int width, int height);
+	// replaces the whole image; pixels are in the format and type that go with the internal format
+	void Upload(const void* pixels) const;
+
+	unsigned int GetID() const { return m_ID; }
+	unsigned int GetInternalFormat() const { return m_InternalFormat; }
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+
+	static unsigned int GetFormat(unsigned int internalFormat);
+	static unsigned int GetType(unsigned int internalFormat);
+
+private:
+	unsigned int m_ID;
+	unsigned int m_InternalFormat;
+	int m_Width;
+	int m_Height;
+};
@@ -1,25 +1,52 @@
-#include "shader.h"
+#include "Shader.h"
+#include <core/Trace.h>
+#include <renderer/GLState.h>
+#include <renderer/GL43.h>
 #include <iostream> 
 
 Shader::Shader(std::string filepath) : m_Filepath(filepath) {
     InitShader();
 }
 
+Shader::Shader(std::string filepath, std::string defines) : m_Filepath(filepath), m_Defines(defines) {
+    InitShader();
+}
+
 void Shader::InitShader()
 {
+    TRACE_SCOPE("Shader::InitShader");
+
     ShaderSources shaders = ParseShader(m_Filepath);
-    u_ID = CreateShader(shaders.Vertex, shaders.Fragment);
+    InjectDefines(shaders.Vertex);
+    InjectDefines(shaders.Fragment);
+    InjectDefines(shaders.Compute);
+
+    if (!shaders.Compute.empty())
+        u_ID = CreateComputeShader(shaders.Compute);
+    else
+        u_ID = CreateShader(shaders.Vertex, shaders.Fragment);
+}
+
+void Shader::InjectDefines(std::string& source)
+{
+    if (m_Defines.empty() || source.empty())
+        return;
+
+    // #version has to stay the first statement
+    size_t version = source.find("#version");
+    size_t insertAt = version == std::string::npos ? 0 : source.find('\n', version) + 1;
+    source.insert(insertAt, m_Defines);
 }
 ShaderSources Shader::ParseShader(const std::string& filepath) {
 
     std::ifstream stream(filepath);
 
     enum ShaderType {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
+        NONE = -1, VERTEX = 0, FRAGMENT = 1, COMPUTE = 2
     };
 
     std::string line;
-    std::stringstream ss[2];
+    std::stringstream ss[3];
     ShaderType type = ShaderType::NONE;
     while (getline(stream, line)) {
         if (line.find("#shader") != std::string::npos) {
@@ -29,6 +56,9 @@ ShaderSources Shader::ParseShader(const std::string& filepath) {
             else if (line.find("fragment") != std::string::npos) {
                 type = ShaderType::FRAGMENT;
             }
+            else if (line.find("compute") != std::string::npos) {
+                type = ShaderType::COMPUTE;
+            }
         }
         else {
             ss[(int)type] << line << "\n";
@@ -37,7 +67,8 @@ ShaderSources Shader::ParseShader(const std::string& filepath) {
 
     return {
         ss[(int)ShaderType::VERTEX].str(),
-        ss[(int)ShaderType::FRAGMENT].str()
+        ss[(int)ShaderType::FRAGMENT].str(),
+        ss[(int)ShaderType::COMPUTE].str()
     };
 }
 
@@ -50,14 +81,12 @@ unsigned int Shader::CompileShader(unsigned int type, std::string& source) {
     int result;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
-        int length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        char* msg = new char[length];
-        glGetShaderInfoLog(id, length, &length, msg);
-        std::cout << "Failed to compile shader " << (type == GL_VERTEX_SHADER ? "vertex" : "fragmenet") << std::endl;
+        // long logs are cut short rather than allocated for
+        char msg[c_InfoLogSize];
+        glGetShaderInfoLog(id, c_InfoLogSize, nullptr, msg);
+        std::cout << "Failed to compile shader " << (type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragmenet" : "compute") << " (" << m_Filepath << ")" << std::endl;
         std::cout << msg << std::endl;
         glDeleteShader(id);
-        delete[] msg;
         return 0;
     }
 
@@ -82,12 +111,34 @@ unsigned int Shader::CreateShader(std::string& vertex_source, std::string& fragm
     return program;
 }
 
+unsigned int Shader::CreateComputeShader(std::string& compute_source) {
+
+    unsigned int program = glCreateProgram();
+    unsigned int cs = CompileShader(GL_COMPUTE_SHADER, compute_source);
+
+    glAttachShader(program, cs);
+    glLinkProgram(program);
+
+    glDeleteShader(cs);
+
+    // the compute path is optional, so report failure instead of handing back a broken program
+    int result;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (cs == 0 || result == GL_FALSE) {
+        std::cout << "Failed to link compute shader (" << m_Filepath << ")" << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
 void Shader::Bind() const {
-    glUseProgram(u_ID);
+    GLState::UseProgram(u_ID);
 }
 
 void Shader::Unbind() const {
-    glUseProgram(0);
+    GLState::UseProgram(0);
 }
 
 unsigned int Shader::GetID()
@@ -95,6 +146,12 @@ unsigned int Shader::GetID()
     return u_ID;
 }
 
+int Shader::GetLocation(const char* name)
+{
+    return glGetUniformLocation(u_ID, name);
+}
+
 Shader::~Shader() {
+    GLState::ForgetProgram(u_ID);
     glDeleteProgram(u_ID);
 }
\ No newline at end of file
@@ -9,25 +9,35 @@
 struct ShaderSources {
     std::string Vertex;
     std::string Fragment;
+    std::string Compute;
 };
 
 class Shader {
 protected:
+    // compile errors longer than this are truncated
+    static constexpr int c_InfoLogSize = 4096;
+
     unsigned int u_ID;
     std::string m_Filepath;
+    std::string m_Defines;
 
 public:
     Shader(std::string filepath);
+    // defines are inserted after the #version line of every stage, e.g. "#define FRACTAL 1\n"
+    Shader(std::string filepath, std::string defines);
     Shader() : u_ID(0) {}
     ~Shader();
 
     void Bind() const;
     void Unbind() const;
     unsigned int GetID();
-    int GetLocation(std::string name);
+    // takes the literal as is, a std::string would be built for every lookup
+    int GetLocation(const char* name);
 
     ShaderSources ParseShader(const std::string& filepath);
     void InitShader();
     unsigned int CompileShader(unsigned int type, std::string& source);
     unsigned int CreateShader(std::string& vertex_source, std::string& fragmement_source);
+    unsigned int CreateComputeShader(std::string& compute_source);
+    void InjectDefines(std::string& source);
 };
\ No newline at end of file
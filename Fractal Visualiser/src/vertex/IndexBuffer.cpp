@@ -1,26 +1,28 @@
 #include "IndexBuffer.h"
 #include <glad/glad.h>
+#include <renderer/GLState.h>
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) :m_Count(count)
 {
 	glGenBuffers(1, &m_ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW);
 }
 
 IndexBuffer::~IndexBuffer()
 {
+	GLState::ForgetBuffer(m_ID);
 	glDeleteBuffers(1, &m_ID);
 }
 
 void IndexBuffer::Bind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 }
 
 void IndexBuffer::Unbind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 unsigned int IndexBuffer::GetCount() const
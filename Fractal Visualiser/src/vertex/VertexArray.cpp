@@ -1,5 +1,6 @@
 #include "VertexArray.h"
 #include "glad/glad.h"
+#include <renderer/GLState.h>
 
 VertexArray::VertexArray()
 {
@@ -8,6 +9,7 @@ VertexArray::VertexArray()
 
 VertexArray::~VertexArray()
 {
+	GLState::ForgetVertexArray(m_ID);
 	glDeleteVertexArrays(1, &m_ID);
 }
 
@@ -15,10 +17,10 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 {
     Bind();
     vb.Bind();
-    std::vector<VertexBufferLayoutElement> elements = layout.GetElements();
+    const std::vector<VertexBufferLayoutElement>& elements = layout.GetElements();
     size_t offset = 0;
     for (int i = 0; i < elements.size(); i++) {
-        const VertexBufferLayoutElement element = elements[i];
+        const VertexBufferLayoutElement& element = elements[i];
         glEnableVertexAttribArray(i);
         glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(),reinterpret_cast<const void*>(offset));
         offset += element.count * VertexBufferLayoutElement::GetSize(element.type);
@@ -27,11 +29,11 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 
 void VertexArray::Bind() const
 {
-	glBindVertexArray(m_ID);
+	GLState::BindVertexArray(m_ID);
 
 }
 
 void VertexArray::Unbind() const
 {
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
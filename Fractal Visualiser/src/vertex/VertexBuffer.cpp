@@ -1,25 +1,27 @@
 #include "VertexBuffer.h"
 #include "glad/glad.h"
+#include <renderer/GLState.h>
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
 {
 	glGenBuffers(1, &m_ID);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_ID);
 	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
 VertexBuffer::~VertexBuffer()
 {
+	GLState::ForgetBuffer(m_ID);
 	glDeleteBuffers(1, &m_ID);
 }
 
 void VertexBuffer::Bind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_ID);
 }
 
 void VertexBuffer::Unbind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
 }
@@ -18,7 +18,7 @@ void VertexBufferLayout::AddAttribute<unsigned int>(unsigned int count)
     m_Stride += VertexBufferLayoutElement::GetSize(GL_UNSIGNED_INT) * count;
 }
 
-std::vector<VertexBufferLayoutElement> VertexBufferLayout::GetElements() const
+const std::vector<VertexBufferLayoutElement>& VertexBufferLayout::GetElements() const
 {
 	return m_Elements;
 }
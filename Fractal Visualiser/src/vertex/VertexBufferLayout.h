@@ -31,7 +31,7 @@ public:
     template <typename T>
     void AddAttribute(unsigned int count);
 
-    std::vector<VertexBufferLayoutElement> GetElements() const;
+    const std::vector<VertexBufferLayoutElement>& GetElements() const;
     unsigned int GetStride() const;
 private:
     unsigned int m_Stride;